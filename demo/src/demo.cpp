@@ -85,35 +85,68 @@ void Demo::ExtractData()
 	// will use the dictionary that was extracted on the first get, even if
 	// we create a new Extractor later in the future.
 
+	// Extraction is thread-safe: worker threads may call get() on the same Extractor
+	// (or on Extractors of their own) at the same time. Reads are positional, so threads
+	// never fight over a shared file position.
+
 	// LoadResource and LoadString are helper functions to make extraction of
 	// SFML and std::string objects from the datafile easier. These functions
 	// call ex.get() with the provided resource category and key.
 
+	// Larger resources can be extracted asynchronously. getAsync() queues the request
+	// on Unlime's internal thread pool and returns a handle immediately, so decompression
+	// and the integrity check of all these resources run in parallel while this thread
+	// carries on with other work. The pool is created on the first getAsync() call with
+	// options.threadCount threads (see Init).
+	Unlime::T_AsyncHandle fontHandle = unlime->getAsync("fonts", "Lato");
+	Unlime::T_AsyncHandle musicHandle = unlime->getAsync("music", "demo");
+	Unlime::T_AsyncHandle backgroundHandle = unlime->getAsync("graphics", "background");
+	Unlime::T_AsyncHandle flagHandle = unlime->getAsync("graphics", "flag");
+	Unlime::T_AsyncHandle cloudHandle = unlime->getAsync("graphics", "cloud");
+
 	// Fetch some strings from meta category.
 	LoadString(metaName, ex, "meta", "name");
 	LoadString(metaVersion, ex, "meta", "version");
 
+	// Retreive the window icon. Here we use a resource ID from demo_resources.h which
+	// indexes the dictionary directly instead of looking the resource up by name.
+	LoadResource(imgIcon, ex, demo_resources::graphics::icon);
+
+	// Resources that are extracted over and over again can also be resolved once at runtime
+	// with ex.find(category, key). The returned Unlime::Handle is then passed to ex.get()
+	// instead of the category and key and stays valid until the dictionary is dropped.
+	// Handles also allow reading part of a resource with ex.read(data, handle, offset, length).
+	// For resources packed in blocks (lime -blocksize) only the blocks covering the requested
+	// range are decompressed, which is handy for streaming large audio or level data.
+
+	// Now collect the results of our asynchronous requests. Calling get() on a handle
+	// waits until the request completes and rethrows any exception thrown during
+	// extraction. In a game loop, we would rather check Unlime::isReady(handle) once per
+	// frame and keep rendering until the data arrives. Unlime::drain() can be used to
+	// wait for all pending requests at once.
+
 	// Here we fetch our font.
 	// We need font data to remain in memory the whole time the application remains open
-	// so we extract fontData manually (as opposed to calling LoadResource which frees byte
+	// so we keep fontData around (as opposed to calling LoadResource which frees byte
 	// data after it's done).
-	if (ex.get(fontData, "fonts", "Lato"))
+	Unlime::AsyncResult fontResult = fontHandle.get();
+	if (fontResult.found)
 	{
+		fontData = std::move(fontResult.data);
 		font.loadFromMemory(fontData.data(), fontData.size());
 	}
 
-	// Retreive the window icon.
-	LoadResource(imgIcon, ex, "graphics", "icon");
-
 	// Now let's acquire data for our textures.
-	LoadResource(texBackground, ex, "graphics", "background");
-	LoadResource(texFlag, ex, "graphics", "flag");
-	LoadResource(texCloud, ex, "graphics", "cloud");
+	LoadResource(texBackground, backgroundHandle);
+	LoadResource(texFlag, flagHandle);
+	LoadResource(texCloud, cloudHandle);
 
 	// Retreive music data.
 	// Same as with the font, we need this data to remain in memory.
-	if (ex.get(musicData, "music", "demo"))
+	Unlime::AsyncResult musicResult = musicHandle.get();
+	if (musicResult.found)
 	{
+		musicData = std::move(musicResult.data);
 		music.openFromMemory(musicData.data(), musicData.size());
 	}
 
@@ -137,6 +170,14 @@ void Demo::Init()
 	// Default is true.
 	options.integrityCheck = true;
 
+	// integrityPolicy decides when checksums are tested (only when integrityCheck is true):
+	// ALWAYS tests every extraction, FIRST_ACCESS tests each resource only the first time
+	// it is extracted, SAMPLED tests one in every integritySampleRate extractions and SCRUB
+	// verifies the whole datafile once on a low-priority background thread instead (see
+	// Unlime::scrubState()). Dictionary data is always tested.
+	// Default is ALWAYS (integritySampleRate defaults to 16).
+	options.integrityPolicy = Unlime::IntegrityPolicy::ALWAYS;
+
 	// checkHeadString makes unlime throw an exception if options.headString does not match
 	// the head string defined in the datafile. This is useful if you want to make sure you
 	// are dealing with the correct datafile.
@@ -149,6 +190,54 @@ void Demo::Init()
 	// Default is an empty string.
 	options.headString = "Lime Demo";
 
+	// memoryMap maps the whole datafile into memory instead of reading it through a file
+	// stream. Data is then decompressed straight from the mapping which avoids the cost of
+	// reading each resource in small chunks. This is worth enabling when loading lots of
+	// resources at once.
+	// Default is false.
+	options.memoryMap = false;
+
+	// threadCount sets the number of worker threads used by Unlime::getAsync().
+	// 0 uses one thread per hardware thread.
+	// Default is 0.
+	options.threadCount = 0;
+
+	// cacheSize sets the memory budget (in bytes) of the decompressed resource cache.
+	// Resources extracted more than once are then served from memory instead of being
+	// decompressed again. Least recently used resources are evicted when the budget is
+	// exceeded; Extractor::pin() keeps a resource in the cache until it is unpinned.
+	// Unlime::cacheStats() reports hits, misses and cache usage. 0 disables the cache.
+	// Default is 0.
+	options.cacheSize = 0;
+
+	// residentCategories lists categories whose compressed data is read into memory in one
+	// go when the dictionary is read. Resources in these categories are then decompressed
+	// straight from memory without touching the datafile again. Compressed data is usually
+	// much smaller than decompressed data, so this is a cheap way to keep resources hot.
+	// Default is empty.
+	options.residentCategories = { "graphics" };
+
+	// lazyDict defers decoding of each dictionary category until a resource from that
+	// category is first requested. Set to false to decode the whole dictionary up front.
+	// Default is true.
+	options.lazyDict = true;
+
+	// readBufferSize is the size of the pieces in which compressed data is read from the
+	// datafile (not used with memoryMap, where data is inflated straight from the mapping).
+	// Default is 16 KiB.
+	options.readBufferSize = 16u * 1024u;
+
+	// batchReadSize limits how much data Extractor::getMany reads in one go when merging
+	// neighbouring resources into a single read.
+	// Default is 4 MiB.
+	options.batchReadSize = 4u * 1024u * 1024u;
+
+	// parallelInflate lets large resources packed in blocks (see lime -blocksize) be
+	// decompressed on several threads of the internal thread pool at once. Each block is
+	// inflated straight into its place in the output, so this needs no extra memory.
+	// Default is true.
+	options.parallelInflate = true;
+
 	// Create the Unlime object and associate it with the demo datafile filename.
 	// The datafile is not open yet at this point, we are only setting up the object and
 	// associating it with the filename.
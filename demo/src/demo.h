@@ -61,6 +61,11 @@
 // Commented out on purpose.
 //#include "unlime_phony.h"
 
+// Resource IDs generated by lime alongside the datafile (see datafile/pack.sh).
+// Each ID names a resource at compile time, so a typo in a resource name is a compile error
+// rather than a failed lookup at runtime. IDs work with both unlime and unlime_phony.
+#include "demo_resources.h"
+
 class Demo
 {
 private:
@@ -125,7 +130,7 @@ private:
 	void PrepareDemo();
 
 	template<class T>
-	static void LoadResource(T& sfmlObject, Unlime::Extractor const& ex, std::string const& resCategory, std::string const& resKey)
+	static void LoadResource(T& sfmlObject, Unlime::Extractor const& ex, std::string_view resCategory, std::string_view resKey)
 	{
 		// load a SFML object using an Extractor to retreive data from the datafile
 		Unlime::T_Bytes data;
@@ -135,7 +140,30 @@ private:
 		}
 	}
 
-	static void LoadString(std::string& strObject, Unlime::Extractor const& ex, std::string const& resCategory, std::string const& resKey)
+	template<class T>
+	static void LoadResource(T& sfmlObject, Unlime::Extractor const& ex, Unlime::ResourceId const& resId)
+	{
+		// same as above but using a resource ID
+		Unlime::T_Bytes data;
+		if (ex.get(data, resId))
+		{
+			sfmlObject.loadFromMemory(data.data(), data.size());
+		}
+	}
+
+	template<class T>
+	static void LoadResource(T& sfmlObject, Unlime::T_AsyncHandle& handle)
+	{
+		// same as above but for data requested with Unlime::getAsync
+		// (get() waits for the request to complete if it hasn't already)
+		Unlime::AsyncResult result = handle.get();
+		if (result.found)
+		{
+			sfmlObject.loadFromMemory(result.data.data(), result.data.size());
+		}
+	}
+
+	static void LoadString(std::string& strObject, Unlime::Extractor const& ex, std::string_view resCategory, std::string_view resKey)
 	{
 		// same as above but for std::string
 		Unlime::T_Bytes data;
@@ -0,0 +1,40 @@
+/*
+ *  Resource IDs for demo.dat
+ *
+ *  Generated by Lime, do not edit. Include unlime.h (or unlime_phony.h) first.
+ *
+ */
+
+#pragma once
+
+#ifndef LIME_RESOURCES_DEMO_RESOURCES_H_
+#define LIME_RESOURCES_DEMO_RESOURCES_H_
+
+namespace demo_resources
+{
+	namespace meta
+	{
+		constexpr Unlime::ResourceId name { 0u, 0u, "meta", "name", 13u, 0xa9c23c052e25c3ceull };
+		constexpr Unlime::ResourceId version { 0u, 1u, "meta", "version", 3u, 0xa9c23c052e25c3ceull };
+	}
+
+	namespace fonts
+	{
+		constexpr Unlime::ResourceId Lato { 1u, 0u, "fonts", "Lato", 75136u, 0xa9c23c052e25c3ceull };
+	}
+
+	namespace graphics
+	{
+		constexpr Unlime::ResourceId icon { 2u, 3u, "graphics", "icon", 10540u, 0xa9c23c052e25c3ceull };
+		constexpr Unlime::ResourceId background { 2u, 0u, "graphics", "background", 4027u, 0xa9c23c052e25c3ceull };
+		constexpr Unlime::ResourceId flag { 2u, 2u, "graphics", "flag", 276u, 0xa9c23c052e25c3ceull };
+		constexpr Unlime::ResourceId cloud { 2u, 1u, "graphics", "cloud", 356u, 0xa9c23c052e25c3ceull };
+	}
+
+	namespace music
+	{
+		constexpr Unlime::ResourceId demo { 3u, 0u, "music", "demo", 483303u, 0xa9c23c052e25c3ceull };
+	}
+}
+
+#endif // LIME_RESOURCES_DEMO_RESOURCES_H_
@@ -37,6 +37,7 @@
 
 #include <string>
 #include <cstdint>
+#include <cstddef>
 
 namespace Lime
 {
@@ -45,7 +46,31 @@ namespace Lime
 	const std::string LIME_COPYRIGHT_AUTHOR = "Danijel Durakovic";
 
 	// format revision number
-	const uint8_t LIME_REVISION = 1;
+	const uint8_t LIME_REVISION = 2;
+
+	// codecs of stored resources
+	const uint8_t LIME_CODEC_DEFLATE = 0;
+	const uint8_t LIME_CODEC_STORED = 1;
+	const uint8_t LIME_CODEC_LZ = 2;
+	const uint8_t LIME_CODEC_PRESET = 3; // deflate with the category's preset dictionary
+	const uint8_t LIME_CODEC_SOLID = 4; // member of a solid group
+
+	// resources larger than this are packed in blocks when the block size is chosen automatically
+	const size_t LIME_AUTO_BLOCK_THRESHOLD = 4u * 1024u * 1024u;
+	const size_t LIME_AUTO_BLOCK_SIZE = 1024u * 1024u;
+
+	// resources up to this size are packed in solid groups, which are split at the group size
+	const size_t LIME_SOLID_MEMBER_SIZE = 64u * 1024u;
+	const size_t LIME_SOLID_GROUP_SIZE = 256u * 1024u;
+
+	// size of trained preset dictionaries (deflate only looks back 32 KiB)
+	const size_t LIME_PRESET_SIZE = 32u * 1024u;
+
+	// records of a category block are front-coded in runs of this many records
+	const size_t LIME_DICT_RUN_LENGTH = 16u;
+
+	// dictionary flags
+	const uint8_t LIME_DICT_HASHED_KEYS = 1u; // category blocks hold 64-bit key hashes instead of keys
 
 	// bgn/end endpoints
 	const std::string LM_BGN_ADLER32 = "L>";
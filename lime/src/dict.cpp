@@ -34,6 +34,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <sstream>
 #include <stdexcept>
 #include "dict.h"
 #include "iniparse.h"
@@ -94,7 +95,7 @@ namespace Lime
 			{
 				// normalize filename path separators to apply to current system
 				// assumes windows uses \ and everything else uses /
-				if (!section.size() || section[0] != '@') // skip meta sections
+				if (!section.size() || (section[0] != '@' && section[0] != '!')) // skip meta and option sections
 				{
 #if defined(_WIN32)
 					std::replace(value.begin(), value.end(), '/', '\\');
@@ -106,7 +107,51 @@ namespace Lime
 			}
 		}
 		
+		// meta categories are stored without their @, so they can't share a name with a category
+		for (auto const& it : outDict)
+		{
+			if (it.first.size() && it.first[0] == '@' && outDict.has(it.first.substr(1)))
+			{
+				throw std::runtime_error("Categories [" + it.first + "] and [" + it.first.substr(1) + "] have the same name.");
+			}
+		}
+
 		// all done
 		return outDict;
 	}
+
+	std::unordered_map<std::string, std::string> takeSolidGroups(Dict& dict)
+	{
+		// removes the [!solid] section from the dictionary and maps each category listed in it
+		// to the name of its group:
+		//   [!solid]
+		//   group = category, category, ...
+		std::unordered_map<std::string, std::string> solidGroups;
+		for (auto const& it : dict.get("!solid"))
+		{
+			std::string category;
+			std::istringstream categoryStream(it.second);
+			while (std::getline(categoryStream, category, ','))
+			{
+				INIParse::trim(category);
+				if (category.size() && category[0] == '@')
+				{
+					category.erase(0, 1);
+				}
+				if (category.size())
+				{
+					solidGroups[category] = it.first;
+				}
+			}
+		}
+		dict.remove("!solid");
+		for (auto const& it : dict)
+		{
+			if (it.first.size() && it.first[0] == '!')
+			{
+				throw std::runtime_error("Unknown manifest section: [" + it.first + "]");
+			}
+		}
+		return solidGroups;
+	}
 }
\ No newline at end of file
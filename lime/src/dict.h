@@ -157,6 +157,8 @@ namespace Lime
 	using Dict = DMap<DMap<std::string>>;
 
 	Dict readDictFromFile(std::string const& resourceManifestFilename);
+
+	std::unordered_map<std::string, std::string> takeSolidGroups(Dict& dict);
 }
 
 #endif // LIME_DICT_H_
@@ -36,6 +36,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cstdlib>
+#include <sstream>
 #include "interface.h"
 #include "dict.h"
 #include "pack.h"
@@ -88,6 +89,34 @@ std::string stripFilenamePathExt(const char* const fullPathFilename)
 	return filename;
 }
 
+std::vector<std::string> parseCategoryList(std::string const& value)
+{
+	// splits a comma separated list of categories, skipping empty entries
+	std::vector<std::string> categories;
+	std::string category;
+	std::istringstream categoryStream(value);
+	while (std::getline(categoryStream, category, ','))
+	{
+		if (category.size())
+		{
+			categories.push_back(category);
+		}
+	}
+	return categories;
+}
+
+unsigned long parseNumber(std::string const& value, unsigned long maxValue, std::string const& optionName)
+{
+	// parses a decimal option value of at most maxValue
+	const bool isNumber = !value.empty() && value.size() <= 10u
+		&& std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; });
+	if (!isNumber || std::stoull(value) > maxValue)
+	{
+		throw std::runtime_error("Invalid " + optionName + " option: " + value);
+	}
+	return std::stoul(value);
+}
+
 int main(int argc, char* argv[])
 {
 	std::vector<std::string> args;
@@ -145,9 +174,21 @@ int main(int argc, char* argv[])
 				<< "    Selects the checksum algorithm to use for data integrity check.\n\n"
 				<< "  -head=[\"string\"] (default: none)\n"
 				<< "    Head string used for datafile identification.\n\n"
+				<< "  -blocksize=[KiB|auto|off] (default: auto)\n"
+				<< "    Packs larger resources in separately compressed blocks of this size.\n\n"
+				<< "  -store=[auto|all|none] (default: auto)\n"
+				<< "    Selects which resources are stored without compression.\n\n"
+				<< "  -lz=[category,...|*] (default: none)\n"
+				<< "    Packs the given categories with the fast LZ codec instead of deflate.\n\n"
+				<< "  -preset=[category,...|*] (default: none)\n"
+				<< "    Trains a shared preset dictionary for each of the given categories.\n\n"
+				<< "  -keys=[names|hashes] (default: names)\n"
+				<< "    Stores keys by name or as 64-bit hashes.\n\n"
+				<< "  -header=[file] (default: none)\n"
+				<< "    Writes a C++ header with resource IDs for the datafile.\n\n"
 				<< "  -h [topic]\n"
 				<< "    Show help for given topic.\n\n"
-				<< "Help topics: basic, examples, structure, manifest, clevel, chksum, head\n";
+				<< "Help topics: basic, examples, structure, manifest, clevel, chksum, head, header, blocksize, store, lz, preset, keys\n";
 		}
 		else
 		{
@@ -179,34 +220,51 @@ int main(int argc, char* argv[])
 			else if (helpTopic == "structure") {
 				inf
 					<< "Lime datafile structure:\n\n"
-					<< "           Z1    ...   Zn    Zdict\n"
-					<< "          [~~~] [~~~] [~~~] [~~~~~~~~~~]       (zipped content)\n\n"
-					<< "   header   user resources   dictionary   end\n"
-					<< " |________|________________|____________|_____|\n\n\n"
+					<< "           Z1    ...   Zn    Zc1  ...  Zck    Zdict\n"
+					<< "          [~~~] [~~~] [~~~] [~~~]     [~~~] [~~~~~~~~~~]       (zipped content)\n\n"
+					<< "   header   user resources   category blocks   dictionary   end\n"
+					<< " |________|________________|_________________|____________|_____|\n\n\n"
 					<< "   Header:\n\n"
-					<< "   bgn   revision-  head*  dict size   dict checksum\n"
-					<< " |_____|__________|______|___________|...............|\n\n\n"
+					<< "   bgn   revision-  head*  dict size   dict raw size   dict checksum\n"
+					<< " |_____|__________|______|___________|_______________|...............|\n\n\n"
 					<< "   Dictionary:\n\n"
-					<< "   N   category 1   ...   category N\n"
-					<< " |___|____________|     |____________|\n"
-					<< "            |\n"
-					<< "            |\n"
-					<< "            |\n"
-					<< "         Category:\n\n"
-					<< "         category key*  M   data 1   ...   data M\n"
-					<< "       |______________|___|________|     |________|\n"
+					<< "   flags-  dict id+  N#  category 1   ...   category N\n"
+					<< " |_______|_________|___|____________|     |____________|\n"
 					<< "                              |\n"
 					<< "                              |\n"
 					<< "                              |\n"
-					<< "                            Data:\n\n"
-					<< "                            data key*  seek_id+  size+  checksum\n"
-					<< "                          |__________|_________|______|..........|\n\n\n"
+					<< "                           Category:\n\n"
+					<< "         category key*  M#  block offset#  block size#  block raw size#  preset offset#  preset size#  preset raw size#  block checksum\n"
+					<< "       |______________|___|______________|____________|________________|_______________|____________|________________|..............|\n\n\n"
+					<< "   Category block:\n\n"
+					<< "   run offset 1   ...   run offset R   data 1   ...   data M\n"
+					<< " |______________|     |______________|________|     |________|\n"
+					<< "                                           |\n"
+					<< "                                           |\n"
+					<< "                                           |\n"
+					<< "                                         Data:\n\n"
+					<< "   shared length#  suffix length#  key suffix  seek_id delta#  size#  raw size#  block size#  codec-  checksum\n"
+					<< " |_______________|_______________|___________|_______________|______|__________|____________|________|..........|\n\n"
+					<< "Data records are sorted by key and front-coded in runs of 16; seek_id is a\n"
+					<< "zigzag-encoded delta from the end of the previous record in the run.\n"
+					<< "With hashed keys (see keys), records are sorted by key hash and the key\n"
+					<< "fields are replaced by a 64-bit key hash+.\n\n\n"
 					<< "All non-resource strings* are stored in the following manner:\n\n"
 					<< "   length-  string\n"
 					<< " |________|________|\n\n"
 					<< "Numeric values are stored as 32-bit unsigned integers.\n"
 					<< "Numeric values marked + are stored as 64-bit unsigned integers.\n"
-					<< "Numeric values marked - are stored as 8-bit unsigned integers.\n";
+					<< "Numeric values marked - are stored as 8-bit unsigned integers.\n"
+					<< "Numeric values marked # are stored as varints (unsigned LEB128).\n\n\n"
+					<< "   Resource packed in blocks (non-zero block size):\n\n"
+					<< "   block end 1+  ...  block end K+   Z1    ...   ZK\n"
+					<< " |_____________|     |_____________|[~~~] [~~~] [~~~]\n\n\n"
+					<< "   LZ sequence (codec 2, lengths marked * continue while bytes are 255):\n\n"
+					<< "   token-  literal count*  literals  offset  match length*\n"
+					<< " |_______|...............|__________|________|...............|\n\n\n"
+					<< "   Solid group (codec 4, block size holds the member's offset in the group):\n\n"
+					<< "   group raw size   Zgroup\n"
+					<< " |________________|[~~~~~~]\n";
 			}
 			else if (helpTopic == "manifest") {
 				inf
@@ -233,7 +291,15 @@ int main(int argc, char* argv[])
 					<< "the category name with @. In this case, all values in the category will\n"
 					<< "be stored directly:\n\n"
 					<< "  [@metadata]\n"
-					<< "  important info = Giraffes are awesome!\n";
+					<< "  important info = Giraffes are awesome!\n\n"
+					<< "Small resources of many similar files compress much better together. The\n"
+					<< "[!solid] section packs the resources of the listed categories into solid\n"
+					<< "groups, which are compressed as a single stream each:\n\n"
+					<< "  [!solid]\n"
+					<< "  ui = strings, layouts\n"
+					<< "  shaders = shaders\n\n"
+					<< "Resources up to 64 KiB are grouped, a group is split once it holds 256 KiB.\n"
+					<< "Unlime inflates a group once and serves all of its resources from it.\n";
 			}
 			else if (helpTopic == "clevel") {
 				inf
@@ -278,6 +344,103 @@ int main(int argc, char* argv[])
 					<< "Pack a datafile using a head string with several spaces:\n"
 					<< "  " << execName << " -head=\"string of custom length\" resources.manifest example.dat\n";
 			}
+			else if (helpTopic == "header") {
+				inf
+					<< "The header option writes a C++ header alongside the datafile. The header\n"
+					<< "declares a constexpr Unlime::ResourceId for every resource in the manifest,\n"
+					<< "grouped into a namespace per category:\n\n"
+					<< "  namespace resources\n"
+					<< "  {\n"
+					<< "    namespace graphics\n"
+					<< "    {\n"
+					<< "      constexpr Unlime::ResourceId sprite1 { 0u, 0u, \"graphics\", \"sprite1\", 1024u };\n"
+					<< "    }\n"
+					<< "  }\n\n"
+					<< "The outer namespace is named after the header file. Category and key names\n"
+					<< "are turned into identifiers by replacing unsupported characters with _.\n\n"
+					<< "Passing a ResourceId to Extractor::get() looks the resource up by index\n"
+					<< "instead of by name, and a mistyped resource name becomes a compile error.\n"
+					<< "Regenerate the header whenever the datafile is repacked.\n\n"
+					<< "Usage: -header=[file]\n\n"
+					<< "Examples:\n\n"
+					<< "Pack a datafile and write resource IDs into resources.h:\n"
+					<< "  " << execName << " -header=resources.h resources.manifest example.dat\n";
+			}
+			else if (helpTopic == "blocksize") {
+				inf
+					<< "The blocksize option splits resources larger than the given size (in KiB)\n"
+					<< "into blocks of that size which are compressed independently. Unlime can\n"
+					<< "then read a range of such a resource by inflating only the blocks that\n"
+					<< "cover it, instead of expanding the whole resource into memory. Smaller\n"
+					<< "blocks make range reads cheaper but compress slightly worse. Blocks of a\n"
+					<< "large resource can also be inflated on several threads at once.\n\n"
+					<< "By default (auto), resources larger than 4 MiB are packed in 1 MiB blocks\n"
+					<< "and smaller resources are packed whole. Use off to disable blocks.\n\n"
+					<< "Usage: -blocksize=[KiB|auto|off]\n\n"
+					<< "Examples:\n\n"
+					<< "Pack resources larger than 64 KiB in 64 KiB blocks:\n"
+					<< "  " << execName << " -blocksize=64 resources.manifest example.dat\n\n"
+					<< "Pack every resource whole:\n"
+					<< "  " << execName << " -blocksize=off resources.manifest example.dat\n";
+			}
+			else if (helpTopic == "store") {
+				inf
+					<< "The store option selects which resources are stored as is instead of being\n"
+					<< "compressed. Stored resources are read straight into memory by Unlime,\n"
+					<< "without going through zlib. With auto, files which are compressed already\n"
+					<< "(such as png, jpg, ogg, mp3 or zip) are stored since deflate can't shrink\n"
+					<< "them, and everything is stored when clevel is 0. Use all to store every\n"
+					<< "resource and none to compress every resource.\n\n"
+					<< "Usage: -store=[auto|all|none]\n\n"
+					<< "Examples:\n\n"
+					<< "Compress every resource, including images and audio:\n"
+					<< "  " << execName << " -store=none resources.manifest example.dat\n";
+			}
+			else if (helpTopic == "lz") {
+				inf
+					<< "The lz option packs resources of the given categories with Lime's built-in\n"
+					<< "LZ codec instead of deflate. LZ data decompresses several times faster but\n"
+					<< "is usually larger, so it suits categories which are loaded while the game\n"
+					<< "is running. Categories are separated by commas, * selects all categories.\n"
+					<< "The compression level sets how hard the packer looks for matches.\n"
+					<< "Resources which are stored without compression (see store) are not\n"
+					<< "affected.\n\n"
+					<< "Usage: -lz=[category,...|*]\n\n"
+					<< "Examples:\n\n"
+					<< "Pack the fonts and levels categories with the LZ codec:\n"
+					<< "  " << execName << " -lz=fonts,levels resources.manifest example.dat\n";
+			}
+			else if (helpTopic == "preset") {
+				inf
+					<< "The preset option trains a preset dictionary for each of the given\n"
+					<< "categories from the content its resources have in common. The dictionary\n"
+					<< "is stored once in the datafile and each deflate stream of the category\n"
+					<< "starts out with it, so categories of many small, similar resources (such\n"
+					<< "as json, shaders or text) compress much better. Unlime loads the dictionary\n"
+					<< "with the category. Categories are separated by commas, * selects all\n"
+					<< "categories. Categories packed with the LZ codec (see lz), stored resources\n"
+					<< "(see store) and resources packed in blocks (see blocksize) don't use it.\n\n"
+					<< "Usage: -preset=[category,...|*]\n\n"
+					<< "Examples:\n\n"
+					<< "Train preset dictionaries for the shaders and strings categories:\n"
+					<< "  " << execName << " -preset=shaders,strings resources.manifest example.dat\n";
+			}
+			else if (helpTopic == "keys") {
+				inf
+					<< "The keys option selects how resource keys are stored in the dictionary.\n"
+					<< "With names (the default), keys are stored as they are. With hashes, each\n"
+					<< "key is replaced by its 64-bit FNV-1a hash, which keeps the dictionary\n"
+					<< "small in the datafile and in Unlime's memory when there are many long\n"
+					<< "keys. Resources are still looked up by name, but the datafile no longer\n"
+					<< "knows its keys and a lookup of a key which was never packed can match a\n"
+					<< "resource with the same hash. Lime stops with an error if two keys of a\n"
+					<< "category have the same hash. Category names are always stored as they are.\n"
+					<< "Short keys are usually stored smaller by name.\n\n"
+					<< "Usage: -keys=[names|hashes]\n\n"
+					<< "Examples:\n\n"
+					<< "Store key hashes instead of keys:\n"
+					<< "  " << execName << " -keys=hashes resources.manifest example.dat\n";
+			}
 			else {
 				inf << "Unknown help topic: " << helpTopic << "\n";
 			}
@@ -299,7 +462,7 @@ int main(int argc, char* argv[])
 				std::string const& propName = prop.first;
 				std::string propValue = prop.second;
 				if (propName == "clevel") {
-					options.clevel = static_cast<unsigned char>(std::stoul(propValue));
+					options.clevel = static_cast<unsigned char>(parseNumber(propValue, 9u, propName));
 				}
 				else if (propName == "chksum") {
 					std::transform(propValue.begin(), propValue.end(), propValue.begin(), ::tolower);
@@ -316,12 +479,62 @@ int main(int argc, char* argv[])
 				else if (propName == "head") {
 					options.headstr = propValue;
 				}
+				else if (propName == "header") {
+					options.headerFilename = propValue;
+				}
+				else if (propName == "lz") {
+					const std::vector<std::string> categories = parseCategoryList(propValue);
+					options.lzCategories.insert(options.lzCategories.end(), categories.begin(), categories.end());
+				}
+				else if (propName == "preset") {
+					const std::vector<std::string> categories = parseCategoryList(propValue);
+					options.presetCategories.insert(options.presetCategories.end(), categories.begin(), categories.end());
+				}
+				else if (propName == "store") {
+					std::transform(propValue.begin(), propValue.end(), propValue.begin(), ::tolower);
+					if (propValue == "auto") {
+						options.store = Lime::StoreOption::AUTO;
+					}
+					else if (propValue == "all") {
+						options.store = Lime::StoreOption::ALL;
+					}
+					else if (propValue == "none") {
+						options.store = Lime::StoreOption::NONE;
+					}
+					else {
+						throw std::runtime_error("Invalid store option: " + propValue);
+					}
+				}
+				else if (propName == "keys") {
+					std::transform(propValue.begin(), propValue.end(), propValue.begin(), ::tolower);
+					if (propValue == "names") {
+						options.hashKeys = false;
+					}
+					else if (propValue == "hashes") {
+						options.hashKeys = true;
+					}
+					else {
+						throw std::runtime_error("Invalid keys option: " + propValue);
+					}
+				}
+				else if (propName == "blocksize") {
+					std::transform(propValue.begin(), propValue.end(), propValue.begin(), ::tolower);
+					options.blockSize = 0;
+					options.autoBlockSize = (propValue == "auto");
+					if (propValue == "auto" || propValue == "off" || propValue == "0") {
+						continue;
+					}
+					// block sizes are stored as 32-bit numbers
+					const unsigned long blockSizeKiB = parseNumber(propValue, 4u * 1024u * 1024u - 1u, propName);
+					options.blockSize = static_cast<size_t>(blockSizeKiB) * 1024u;
+				}
 			}
 
 			inf << "Reading resource manifest ... ";
 
 			// read dictionary definitions from the resource manifest
 			Lime::Dict dict = Lime::readDictFromFile(resourceManifestFilename);
+			options.solidGroups = Lime::takeSolidGroups(dict);
 
 			// successfully read resource manifest
 			inf.ok() << "\n\n";
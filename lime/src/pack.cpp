@@ -33,7 +33,9 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
+#include <cctype>
 #include <iterator>
 #include <sys/stat.h>
 #include <fstream>
@@ -210,6 +212,49 @@ namespace Lime
 		{
 			inf << "Using head string: " << options.headstr << "\n";
 		}
+		if (options.blockSize > 0)
+		{
+			inf << "Using block size: " << std::to_string(options.blockSize / 1024u) << " KiB\n";
+		}
+		else if (options.autoBlockSize)
+		{
+			inf << "Using block size: auto\n";
+		}
+		if (options.lzCategories.size())
+		{
+			inf << "Using LZ codec for:";
+			for (auto const& category : options.lzCategories)
+			{
+				inf << " " << category;
+			}
+			inf << "\n";
+		}
+		if (options.presetCategories.size())
+		{
+			inf << "Using preset dictionaries for:";
+			for (auto const& category : options.presetCategories)
+			{
+				inf << " " << category;
+			}
+			inf << "\n";
+		}
+		if (options.solidGroups.size())
+		{
+			inf << "Using solid groups for:";
+			for (auto const& it : options.solidGroups)
+			{
+				inf << " " << it.first;
+			}
+			inf << "\n";
+		}
+		if (options.store == StoreOption::ALL || (options.store == StoreOption::AUTO && options.clevel == 0))
+		{
+			inf << "Storing all resources without compression.\n";
+		}
+		else if (options.store == StoreOption::NONE)
+		{
+			inf << "Compressing all resources.\n";
+		}
 	}
 
 	inline void capStringSizeTo255(std::string& str)
@@ -221,43 +266,930 @@ namespace Lime
 		}
 	}
 
+	struct DictItemData
+	{
+		size_t offset = 0;
+		uint32_t checksum = 0;
+		size_t size = 0;
+		size_t rawSize = 0;
+		uint32_t blockSize = 0; // offset in the inflated group for LIME_CODEC_SOLID
+		uint8_t codec = LIME_CODEC_DEFLATE;
+	};
+
+	bool isCompressedFormat(std::string const& filename)
+	{
+		// file formats which are compressed already, deflate can't make these any smaller
+		static const char* const compressedExtensions[] = {
+			"png", "jpg", "jpeg", "gif", "webp", "ogg", "oga", "opus", "mp3", "flac", "m4a",
+			"mp4", "webm", "zip", "gz", "xz", "bz2", "7z", "zst", "woff", "woff2"
+		};
+		const size_t dotPos = filename.find_last_of("./\\");
+		if (dotPos == std::string::npos || filename[dotPos] != '.')
+		{
+			return false;
+		}
+		std::string extension = filename.substr(dotPos + 1u);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		for (const char* compressedExtension : compressedExtensions)
+		{
+			if (extension == compressedExtension)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool shouldStore(PackOptions const& options, std::string const& filename)
+	{
+		// decides whether a resource is stored as is rather than compressed
+		// (meta values are passed with an empty filename)
+		switch (options.store)
+		{
+			case StoreOption::ALL:
+				return true;
+			case StoreOption::NONE:
+				return false;
+			default:
+				return options.clevel == 0 || isCompressedFormat(filename);
+		}
+	}
+
+	std::string toIdentifier(std::string const& name)
+	{
+		// turns a category or key name into a valid C++ identifier
+		static const char* const reservedWords[] = {
+			"alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+			"class", "const", "constexpr", "continue", "decltype", "default", "delete", "do",
+			"double", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+			"friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new",
+			"noexcept", "not", "nullptr", "operator", "or", "private", "protected", "public",
+			"register", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+			"template", "this", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+			"unsigned", "using", "virtual", "void", "volatile", "while", "xor"
+		};
+		std::string identifier;
+		for (char c : name)
+		{
+			identifier += (std::isalnum(static_cast<unsigned char>(c))) ? c : '_';
+		}
+		if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0])))
+		{
+			identifier.insert(0, 1, '_');
+		}
+		for (const char* reservedWord : reservedWords)
+		{
+			if (identifier == reservedWord)
+			{
+				identifier += '_';
+				break;
+			}
+		}
+		return identifier;
+	}
+
+	std::string toUniqueIdentifier(std::string const& name, std::unordered_map<std::string, size_t>& usedIdentifiers)
+	{
+		// names that map to the same identifier are numbered
+		std::string identifier = toIdentifier(name);
+		size_t& n_uses = usedIdentifiers[identifier];
+		if (n_uses++ > 0)
+		{
+			identifier += "_" + std::to_string(n_uses);
+		}
+		return identifier;
+	}
+
+	std::string toStringLiteral(std::string const& str)
+	{
+		std::string literal = "\"";
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				literal += '\\';
+			}
+			literal += c;
+		}
+		literal += '"';
+		return literal;
+	}
+
+	void appendVarint(T_Bytes& bytes, uint64_t value)
+	{
+		// unsigned LEB128: 7 bits per byte, least significant first, the high bit is set on
+		// every byte but the last
+		while (value >= 0x80u)
+		{
+			bytes.push_back(static_cast<Bytef>(value | 0x80u));
+			value >>= 7;
+		}
+		bytes.push_back(static_cast<Bytef>(value));
+	}
+
+	inline uint64_t zigzag(int64_t value)
+	{
+		// maps signed values to unsigned ones so small negative values stay small as varints
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	uint64_t hashBytes(Bytef const* data, size_t size, uint64_t value = 14695981039346656037ull)
+	{
+		// 64-bit FNV-1a, continues value over size more bytes of data
+		for (size_t i = 0; i < size; ++i)
+		{
+			value ^= data[i];
+			value *= 1099511628211ull;
+		}
+		return value;
+	}
+
+	uint64_t hashKey(std::string const& key)
+	{
+		// the hash Unlime uses for hashed keys
+		return hashBytes(reinterpret_cast<Bytef const*>(key.data()), key.size());
+	}
+
+	void checkKeyHashes(Dict const& dict)
+	{
+		// hashed keys have to be unique within their category
+		for (auto const& it : dict)
+		{
+			std::unordered_map<uint64_t, std::string const*> keyOfHash;
+			for (auto const& it2 : it.second)
+			{
+				auto inserted = keyOfHash.emplace(hashKey(it2.first), &it2.first);
+				if (!inserted.second)
+				{
+					throw std::runtime_error("Keys \"" + *inserted.first->second + "\" and \"" + it2.first + "\" in category \"" + it.first + "\" have the same hash.");
+				}
+			}
+		}
+	}
+
+	std::vector<DMap<DictItemData>::const_iterator> lookupOrderOf(DMap<DictItemData> const& collection, bool hashKeys)
+	{
+		// order of the records in a category block: sorted by key, or by key hash for hashed keys
+		std::vector<DMap<DictItemData>::const_iterator> order;
+		order.reserve(collection.size());
+		for (auto it = collection.begin(); it != collection.end(); ++it)
+		{
+			order.push_back(it);
+		}
+		if (hashKeys)
+		{
+			std::sort(order.begin(), order.end(), [](auto const& a, auto const& b) {
+				return hashKey(a->first) < hashKey(b->first);
+			});
+		}
+		else
+		{
+			std::sort(order.begin(), order.end(), [](auto const& a, auto const& b) {
+				return a->first < b->first;
+			});
+		}
+		return order;
+	}
+
+	T_Bytes buildCategoryBlock(DMap<DictItemData> const& collection, PackOptions const& options)
+	{
+		// lays out the data records of a category sorted by key, in runs of
+		// LIME_DICT_RUN_LENGTH records which start with a table of run offsets; within a run
+		// keys are front-coded (or replaced by their hash) and offsets are relative to the end
+		// of the previous record
+		T_Bytes runTableBytes;
+		T_Bytes recordBytes;
+		std::string previousKey;
+		uint64_t previousEnd = 0;
+		size_t itemIndex = 0;
+		for (auto const& it : lookupOrderOf(collection, options.hashKeys))
+		{
+			auto const& collectionKey = it->first;
+			auto const& itemData = it->second;
+
+			if (itemIndex++ % LIME_DICT_RUN_LENGTH == 0)
+			{
+				appendBytes(runTableBytes, toBytes(toBigEndian(static_cast<uint32_t>(recordBytes.size()))));
+				previousKey.clear();
+				previousEnd = 0;
+			}
+
+			if (options.hashKeys)
+			{
+				appendBytes(recordBytes, toBytes(toBigEndian(hashKey(collectionKey))));
+			}
+			else
+			{
+				size_t sharedLength = 0;
+				while (sharedLength < previousKey.size() && sharedLength < collectionKey.size() && previousKey[sharedLength] == collectionKey[sharedLength])
+				{
+					++sharedLength;
+				}
+				appendVarint(recordBytes, sharedLength);
+				appendVarint(recordBytes, collectionKey.size() - sharedLength);
+				recordBytes.insert(recordBytes.end(), collectionKey.begin() + sharedLength, collectionKey.end());
+			}
+
+			appendVarint(recordBytes, zigzag(static_cast<int64_t>(itemData.offset) - static_cast<int64_t>(previousEnd)));
+			appendVarint(recordBytes, itemData.size);
+			appendVarint(recordBytes, itemData.rawSize);
+			appendVarint(recordBytes, itemData.blockSize);
+			recordBytes.push_back(itemData.codec);
+
+			if (options.chksum != ChkSumOption::NONE)
+			{
+				uint32_t const& checksum = itemData.checksum;
+				appendBytes(recordBytes, toBytes(toBigEndian(checksum)));
+			}
+
+			previousKey = collectionKey;
+			previousEnd = static_cast<uint64_t>(itemData.offset + itemData.size);
+		}
+
+		T_Bytes blockBytes;
+		appendBytes(blockBytes, runTableBytes);
+		appendBytes(blockBytes, recordBytes);
+		return blockBytes;
+	}
+
+	void writeResourceHeader(std::string const& headerFilename, std::string const& datafileFilename, DMap<DMap<DictItemData>> const& dictDataMap, bool hashKeys, uint64_t dictId)
+	{
+		/*
+
+		Writes a C++ header with a constexpr Unlime::ResourceId for every resource:
+
+		  namespace [header filename]
+		  {
+		  	namespace [category]
+		  	{
+		  		constexpr Unlime::ResourceId [key] { category index, item index, "category", "key", raw size, dict id };
+		  	}
+		  }
+
+		Indices refer to the order of categories and items in the datafile dictionary, the dict id
+		tells Unlime whether they were written for the datafile it reads.
+
+		*/
+
+		std::string headerName = headerFilename;
+		const size_t lastSlashPos = headerName.find_last_of("\\/");
+		if (lastSlashPos != std::string::npos)
+		{
+			headerName.erase(0, lastSlashPos + 1);
+		}
+		std::string datafileName = datafileFilename;
+		const size_t datafileSlashPos = datafileName.find_last_of("\\/");
+		if (datafileSlashPos != std::string::npos)
+		{
+			datafileName.erase(0, datafileSlashPos + 1);
+		}
+		const size_t periodPos = headerName.rfind('.');
+		const std::string namespaceName = toIdentifier(headerName.substr(0, periodPos));
+		std::string includeGuard = "LIME_RESOURCES_" + toIdentifier(headerName) + "_";
+		std::transform(includeGuard.begin(), includeGuard.end(), includeGuard.begin(), ::toupper);
+
+		std::ofstream headerStream(headerFilename, std::ios::out | std::ios::trunc);
+		if (!headerStream.is_open())
+		{
+			throw std::runtime_error("Unable to open file for writing: " + headerFilename);
+		}
+
+		headerStream
+			<< "/*\n"
+			<< " *  Resource IDs for " << datafileName << "\n"
+			<< " *\n"
+			<< " *  Generated by Lime, do not edit. Include unlime.h (or unlime_phony.h) first.\n"
+			<< " *\n"
+			<< " */\n\n"
+			<< "#pragma once\n\n"
+			<< "#ifndef " << includeGuard << "\n"
+			<< "#define " << includeGuard << "\n\n"
+			<< "namespace " << namespaceName << "\n"
+			<< "{\n";
+
+		std::unordered_map<std::string, size_t> usedCategoryIdentifiers;
+		size_t categoryIndex = 0;
+		for (auto const& it : dictDataMap)
+		{
+			std::string categoryKey = it.first;
+			if (categoryKey.length() && categoryKey[0] == '@')
+			{
+				categoryKey.erase(0, 1);
+			}
+
+			if (categoryIndex > 0)
+			{
+				headerStream << "\n";
+			}
+			headerStream
+				<< "\tnamespace " << toUniqueIdentifier(categoryKey, usedCategoryIdentifiers) << "\n"
+				<< "\t{\n";
+
+			// items are indexed in the order of the category block's records
+			std::unordered_map<std::string, size_t> itemIndices;
+			for (auto const& itemIt : lookupOrderOf(it.second, hashKeys))
+			{
+				itemIndices.emplace(itemIt->first, itemIndices.size());
+			}
+
+			std::unordered_map<std::string, size_t> usedKeyIdentifiers;
+			for (auto const& it2 : it.second)
+			{
+				headerStream
+					<< "\t\tconstexpr Unlime::ResourceId " << toUniqueIdentifier(it2.first, usedKeyIdentifiers)
+					<< " { " << categoryIndex << "u, " << itemIndices[it2.first] << "u, "
+					<< toStringLiteral(categoryKey) << ", " << toStringLiteral(it2.first) << ", "
+					<< it2.second.rawSize << "u, 0x" << std::hex << dictId << std::dec << "ull };\n";
+			}
+
+			headerStream << "\t}\n";
+			++categoryIndex;
+		}
+
+		headerStream
+			<< "}\n\n"
+			<< "#endif // " << includeGuard << "\n";
+	}
+
+	uint32_t checksumOf(ChkSumOption chksum, Bytef const* data, size_t size, uint32_t checksum = 0u)
+	{
+		// continues checksum over size more bytes of data
+		switch (chksum)
+		{
+			case ChkSumOption::ADLER32:
+				return adler32_z(checksum, data, size);
+			case ChkSumOption::CRC32:
+				return crc32_z(checksum, data, size);
+			default:
+				return 0u;
+		}
+	}
+
+	uint32_t checksumOf(ChkSumOption chksum, T_Bytes const& bytes)
+	{
+		return checksumOf(chksum, bytes.data(), bytes.size());
+	}
+
+	size_t writeCompressed(std::ofstream& stream, T_Bytes const& bytes, unsigned char clevel, std::string const& subject)
+	{
+		// compresses bytes in one go and writes them to stream, returns the compressed size
+		// subject names what is compressed in the error message
+		uLong compressedSize = compressBound(static_cast<uLong>(bytes.size()));
+		T_Bytes compressedBytes(compressedSize);
+		if (compress2(compressedBytes.data(), &compressedSize, bytes.data(), static_cast<uLong>(bytes.size()), clevel) != Z_OK)
+		{
+			throw std::runtime_error("Unable to compress " + subject + ".");
+		}
+		stream.write(reinterpret_cast<const char*>(compressedBytes.data()), static_cast<size_t>(compressedSize));
+		return static_cast<size_t>(compressedSize);
+	}
+
+	void writeStored(std::ofstream& datafileStream, std::ifstream& resourceStream, size_t resourceSize, PackOptions const& options, uint32_t& checksum)
+	{
+		// copies a resource to the datafile as is
+		static const size_t copyBuffSize = 64u * 1024u;
+		T_Bytes copyBytes(copyBuffSize);
+		size_t remainingSize = resourceSize;
+		while (remainingSize > 0)
+		{
+			const size_t chunkSize = std::min(copyBuffSize, remainingSize);
+			resourceStream.read(reinterpret_cast<char*>(copyBytes.data()), chunkSize);
+			if (static_cast<size_t>(resourceStream.gcount()) != chunkSize)
+			{
+				throw std::runtime_error("Unable to read data.");
+			}
+
+			checksum = checksumOf(options.chksum, copyBytes.data(), chunkSize, checksum);
+
+			datafileStream.write(reinterpret_cast<const char*>(copyBytes.data()), chunkSize);
+			remainingSize -= chunkSize;
+		}
+	}
+
+	void compressLz(T_Bytes& output, Bytef const* input, size_t size, unsigned char clevel)
+	{
+		// compresses data with the built-in LZ codec (see format.txt), a byte-aligned LZ77
+		// variant which decodes several times faster than deflate at a somewhat lower ratio
+		// clevel sets how many earlier positions are searched for each match
+		static const size_t minMatchLength = 4u;
+		static const size_t maxMatchOffset = 65535u;
+		static const unsigned int hashBits = 16u;
+		const size_t maxChainLength = static_cast<size_t>(1u) << (std::max(static_cast<int>(clevel), 1) - 1);
+
+		// head holds the last position of each hash, chain links every position in the
+		// window to the previous position with the same hash
+		std::vector<int64_t> head(static_cast<size_t>(1u) << hashBits, -1);
+		std::vector<int64_t> chain(maxMatchOffset + 1u, -1);
+
+		auto hashAt = [input](size_t pos) {
+			const uint32_t value = static_cast<uint32_t>(input[pos]) | (static_cast<uint32_t>(input[pos + 1]) << 8)
+				| (static_cast<uint32_t>(input[pos + 2]) << 16) | (static_cast<uint32_t>(input[pos + 3]) << 24);
+			return static_cast<size_t>((value * 2654435761u) >> (32u - hashBits));
+		};
+		auto insert = [&](size_t pos) {
+			const size_t hash = hashAt(pos);
+			chain[pos & maxMatchOffset] = head[hash];
+			head[hash] = static_cast<int64_t>(pos);
+		};
+		auto writeLength = [&output](size_t length) {
+			while (length >= 255u)
+			{
+				output.push_back(255u);
+				length -= 255u;
+			}
+			output.push_back(static_cast<Bytef>(length));
+		};
+		auto writeSequence = [&](size_t literalBegin, size_t literalCount, size_t matchOffset, size_t matchLength) {
+			// a match length of 0 marks the last sequence, which holds literals only
+			const size_t matchCode = (matchLength > 0) ? matchLength - minMatchLength : 0u;
+			output.push_back(static_cast<Bytef>((std::min(literalCount, static_cast<size_t>(15u)) << 4) | std::min(matchCode, static_cast<size_t>(15u))));
+			if (literalCount >= 15u)
+			{
+				writeLength(literalCount - 15u);
+			}
+			output.insert(output.end(), input + literalBegin, input + literalBegin + literalCount);
+			if (matchLength > 0)
+			{
+				output.push_back(static_cast<Bytef>(matchOffset & 0xffu));
+				output.push_back(static_cast<Bytef>(matchOffset >> 8));
+				if (matchCode >= 15u)
+				{
+					writeLength(matchCode - 15u);
+				}
+			}
+		};
+
+		output.clear();
+		size_t pos = 0;
+		size_t anchor = 0;
+		while (pos + minMatchLength <= size)
+		{
+			// find the longest match among earlier positions with the same hash
+			size_t bestLength = 0;
+			size_t bestOffset = 0;
+			const size_t maxLength = size - pos;
+			int64_t candidate = head[hashAt(pos)];
+			for (size_t i = 0; i < maxChainLength && candidate >= 0 && pos - static_cast<size_t>(candidate) <= maxMatchOffset; ++i)
+			{
+				const size_t candidatePos = static_cast<size_t>(candidate);
+				size_t length = 0;
+				while (length < maxLength && input[candidatePos + length] == input[pos + length])
+				{
+					++length;
+				}
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestOffset = pos - candidatePos;
+					if (length == maxLength)
+					{
+						break;
+					}
+				}
+				candidate = chain[candidatePos & maxMatchOffset];
+			}
+
+			if (bestLength < minMatchLength)
+			{
+				insert(pos++);
+				continue;
+			}
+
+			writeSequence(anchor, pos - anchor, bestOffset, bestLength);
+			const size_t matchEnd = pos + bestLength;
+			for (; pos < matchEnd && pos + minMatchLength <= size; ++pos)
+			{
+				insert(pos);
+			}
+			pos = anchor = matchEnd;
+		}
+		writeSequence(anchor, size - anchor, 0u, 0u);
+	}
+
+	void compressWith(uint8_t codec, T_Bytes& output, Bytef const* input, size_t size, unsigned char clevel, T_Bytes const* preset = nullptr)
+	{
+		// compresses data with the given codec (deflate, LZ or deflate with a preset dictionary)
+		if (codec == LIME_CODEC_LZ)
+		{
+			compressLz(output, input, size, clevel);
+			return;
+		}
+
+		z_stream cmpStream;
+		cmpStream.zalloc = Z_NULL;
+		cmpStream.zfree = Z_NULL;
+		cmpStream.opaque = Z_NULL;
+		if (deflateInit(&cmpStream, clevel) != Z_OK)
+		{
+			throw std::runtime_error("Unable to compress data.");
+		}
+		if (codec == LIME_CODEC_PRESET && deflateSetDictionary(&cmpStream, preset->data(), static_cast<uInt>(preset->size())) != Z_OK)
+		{
+			deflateEnd(&cmpStream);
+			throw std::runtime_error("Unable to compress data.");
+		}
+		output.resize(deflateBound(&cmpStream, static_cast<uLong>(size)));
+		cmpStream.next_in = const_cast<Bytef*>(input);
+		cmpStream.avail_in = static_cast<uInt>(size);
+		cmpStream.next_out = output.data();
+		cmpStream.avail_out = static_cast<uInt>(output.size());
+		const int streamState = deflate(&cmpStream, Z_FINISH);
+		deflateEnd(&cmpStream);
+		if (streamState != Z_STREAM_END)
+		{
+			throw std::runtime_error("Unable to compress data.");
+		}
+		output.resize(cmpStream.total_out);
+	}
+
+	bool isCategoryListed(std::vector<std::string> const& categories, std::string category)
+	{
+		// checks a category against a list of category names given as an option (* lists all)
+		if (category.size() && category[0] == '@')
+		{
+			category.erase(0, 1);
+		}
+		return std::find_if(categories.begin(), categories.end(), [&category](std::string const& listed) {
+			return listed == "*" || listed == category;
+		}) != categories.end();
+	}
+
+	uint8_t codecOf(PackOptions const& options, std::string const& category)
+	{
+		// selects the codec of a (non-stored) resource by its category
+		return isCategoryListed(options.lzCategories, category) ? LIME_CODEC_LZ : LIME_CODEC_DEFLATE;
+	}
+
+	T_Bytes trainPreset(std::vector<T_Bytes> const& samples)
+	{
+		// builds a deflate preset dictionary from the most common content of the samples:
+		// every 8-byte sequence is counted once per sample it appears in, samples are cut into
+		// segments which are scored by how common their sequences are, and the best segments
+		// are concatenated with the best one last (deflate finds close matches cheapest)
+		// counts are kept in a fixed-size table indexed by a hash of the sequence, sequences
+		// which share a slot share their count
+		static const size_t sequenceLength = 8u;
+		static const size_t segmentLength = 64u;
+		static const unsigned countTableBits = 19u;
+
+		T_Bytes preset;
+		if (samples.size() < 2u)
+		{
+			return preset;
+		}
+
+		auto sequenceAt = [](Bytef const* bytes) {
+			uint64_t sequence = 0;
+			for (size_t i = 0; i < sequenceLength; ++i)
+			{
+				sequence = (sequence << 8) | bytes[i];
+			}
+			return sequence;
+		};
+
+		auto slotOf = [](uint64_t sequence) {
+			return static_cast<size_t>((sequence * 0x9E3779B97F4A7C15ull) >> (64u - countTableBits));
+		};
+
+		// slot -> number of samples its sequences appear in, last sample it was counted for
+		std::vector<std::pair<uint32_t, uint32_t>> sequenceCounts(size_t(1) << countTableBits, std::make_pair(0u, UINT32_MAX));
+		for (size_t s = 0; s < samples.size(); ++s)
+		{
+			T_Bytes const& sample = samples[s];
+			for (size_t pos = 0; pos + sequenceLength <= sample.size(); ++pos)
+			{
+				auto& count = sequenceCounts[slotOf(sequenceAt(&sample[pos]))];
+				if (count.second != s)
+				{
+					count.first++;
+					count.second = static_cast<uint32_t>(s);
+				}
+			}
+		}
+
+		struct Segment
+		{
+			Bytef const* data;
+			size_t size;
+			uint64_t score;
+		};
+		std::vector<Segment> segments;
+		for (auto const& sample : samples)
+		{
+			for (size_t begin = 0; begin < sample.size(); begin += segmentLength)
+			{
+				const size_t end = std::min(begin + segmentLength, sample.size());
+				uint64_t score = 0;
+				for (size_t pos = begin; pos < end && pos + sequenceLength <= sample.size(); ++pos)
+				{
+					score += sequenceCounts[slotOf(sequenceAt(&sample[pos]))].first - 1u;
+				}
+				if (score > 0)
+				{
+					segments.push_back({ &sample[begin], end - begin, score });
+				}
+			}
+		}
+		std::stable_sort(segments.begin(), segments.end(), [](Segment const& a, Segment const& b) {
+			return a.score > b.score;
+		});
+
+		// pick the best segments, skipping repeats of segments already picked
+		std::vector<Segment const*> picked;
+		std::unordered_set<std::string> pickedContents;
+		size_t presetSize = 0;
+		for (auto const& segment : segments)
+		{
+			if (presetSize + segment.size > LIME_PRESET_SIZE)
+			{
+				break;
+			}
+			if (!pickedContents.emplace(reinterpret_cast<const char*>(segment.data), segment.size).second)
+			{
+				continue;
+			}
+			picked.push_back(&segment);
+			presetSize += segment.size;
+		}
+		for (auto it = picked.rbegin(); it != picked.rend(); ++it)
+		{
+			preset.insert(preset.end(), (*it)->data, (*it)->data + (*it)->size);
+		}
+		return preset;
+	}
+
+	T_Bytes trainCategoryPreset(std::string const& category, DMap<std::string> const& collection, PackOptions const& options)
+	{
+		// trains a preset dictionary on the beginning of resources in a category that are
+		// compressed with deflate in one piece; large categories are sampled at a stride so
+		// the samples stay within a fixed budget but still cover the whole category
+		static const size_t maxSampleSize = 16u * 1024u;
+		static const size_t maxSampleCount = 1024u;
+		static const size_t maxSamplesSize = 4u * 1024u * 1024u;
+
+		const bool isMeta = (category.length() && category[0] == '@');
+
+		// stored resources (meta values are passed with an empty filename) are not compressed
+		std::vector<std::string const*> candidates;
+		for (auto const& it : collection)
+		{
+			if (!shouldStore(options, isMeta ? std::string() : it.second))
+			{
+				candidates.push_back(&it.second);
+			}
+		}
+		const size_t stride = (candidates.size() + maxSampleCount - 1u) / maxSampleCount;
+
+		std::vector<T_Bytes> samples;
+		size_t samplesSize = 0;
+		for (size_t i = 0; i < candidates.size() && samplesSize < maxSamplesSize; i += stride)
+		{
+			std::string const& value = *candidates[i];
+			const size_t sampleSize = std::min(maxSampleSize, maxSamplesSize - samplesSize);
+			T_Bytes sample;
+			if (isMeta)
+			{
+				sample.assign(value.begin(), value.begin() + std::min(value.size(), sampleSize));
+			}
+			else
+			{
+				std::ifstream sampleStream(value, std::ios::in | std::ifstream::binary);
+				sample.resize(sampleSize);
+				sampleStream.read(reinterpret_cast<char*>(sample.data()), sampleSize);
+				sample.resize(static_cast<size_t>(sampleStream.gcount()));
+			}
+			samplesSize += sample.size();
+			samples.push_back(std::move(sample));
+		}
+		return trainPreset(samples);
+	}
+
+	// location of a category's preset dictionary in the datafile
+	struct PresetData
+	{
+		size_t offset = 0;
+		size_t size = 0;
+		size_t rawSize = 0;
+	};
+
+	// resource waiting to be packed in a solid group
+	struct SolidMember
+	{
+		std::string category;
+		std::string key;
+		std::string source; // filename, or the value of a meta key
+		bool isMeta = false;
+	};
+
+	std::string const* solidGroupOf(PackOptions const& options, std::string category)
+	{
+		// finds the solid group of a category, nullptr if the category is not grouped
+		if (category.size() && category[0] == '@')
+		{
+			category.erase(0, 1);
+		}
+		auto it = options.solidGroups.find(category);
+		return (it != options.solidGroups.end()) ? &it->second : nullptr;
+	}
+
+	void writeSolidGroups(std::ofstream& datafileStream, DMap<std::vector<SolidMember>> const& solidGroupMap, DMap<DMap<DictItemData>>& dictDataMap, PackOptions const& options, size_t& totalRead)
+	{
+		// packs the members of each group, in manifest order, into groups of up to
+		// LIME_SOLID_GROUP_SIZE bytes; a group is stored as its 32-bit raw size followed by
+		// a single zlib stream and every member records its offset in the inflated group
+		for (auto const& it : solidGroupMap)
+		{
+			T_Bytes groupBytes;
+			std::vector<std::pair<SolidMember const*, DictItemData>> pendingMembers;
+			std::unordered_map<std::string, DictItemData> knownSources; // members shared within the group
+
+			auto writeGroup = [&]() {
+				if (pendingMembers.empty())
+				{
+					return;
+				}
+				const size_t offset = datafileStream.tellp();
+				const uint32_t groupRawSize = static_cast<uint32_t>(groupBytes.size());
+				T_Bytes groupRawSizeBytes = toBytes(toBigEndian(groupRawSize));
+				datafileStream.write(reinterpret_cast<const char*>(groupRawSizeBytes.data()), groupRawSizeBytes.size());
+				const size_t groupSize = groupRawSizeBytes.size() + writeCompressed(datafileStream, groupBytes, options.clevel, "solid group " + it.first);
+				for (auto& pendingMember : pendingMembers)
+				{
+					DictItemData& itemData = pendingMember.second;
+					itemData.offset = offset;
+					itemData.size = groupSize;
+					dictDataMap[pendingMember.first->category][pendingMember.first->key] = itemData;
+				}
+				groupBytes.clear();
+				pendingMembers.clear();
+				knownSources.clear();
+			};
+
+			for (auto const& member : it.second)
+			{
+				T_Bytes memberBytes;
+				if (member.isMeta)
+				{
+					memberBytes.assign(member.source.begin(), member.source.end());
+				}
+				else
+				{
+					std::ifstream resourceStream(member.source, std::ios::in | std::ifstream::binary);
+					if (!resourceStream.is_open())
+					{
+						throw std::runtime_error("Unable to open file: " + member.source);
+					}
+					memberBytes.resize(fileSize(member.source.c_str()));
+					resourceStream.read(reinterpret_cast<char*>(memberBytes.data()), memberBytes.size());
+					if (static_cast<size_t>(resourceStream.gcount()) != memberBytes.size())
+					{
+						throw std::runtime_error("Unable to read data.");
+					}
+				}
+
+				if (groupBytes.size() + memberBytes.size() > LIME_SOLID_GROUP_SIZE)
+				{
+					writeGroup();
+				}
+
+				const std::string knownSource = (member.isMeta ? "@" : "") + member.source;
+				auto knownSourceIt = knownSources.find(knownSource);
+				if (knownSourceIt != knownSources.end())
+				{
+					pendingMembers.emplace_back(&member, knownSourceIt->second);
+					continue;
+				}
+
+				DictItemData itemData;
+				itemData.checksum = checksumOf(options.chksum, memberBytes);
+				itemData.rawSize = memberBytes.size();
+				itemData.blockSize = static_cast<uint32_t>(groupBytes.size());
+				itemData.codec = LIME_CODEC_SOLID;
+				knownSources[knownSource] = itemData;
+				pendingMembers.emplace_back(&member, itemData);
+
+				appendBytes(groupBytes, memberBytes);
+				totalRead += memberBytes.size();
+			}
+			writeGroup();
+		}
+	}
+
+	size_t writeLz(std::ofstream& datafileStream, std::ifstream& resourceStream, size_t resourceSize, PackOptions const& options, uint32_t& checksum)
+	{
+		// packs a whole resource with the LZ codec, returns the number of bytes written
+		T_Bytes resourceBytes(resourceSize);
+		resourceStream.read(reinterpret_cast<char*>(resourceBytes.data()), resourceSize);
+		if (static_cast<size_t>(resourceStream.gcount()) != resourceSize)
+		{
+			throw std::runtime_error("Unable to read data.");
+		}
+		checksum = checksumOf(options.chksum, resourceBytes);
+
+		T_Bytes compressedBytes;
+		compressLz(compressedBytes, resourceBytes.data(), resourceBytes.size(), options.clevel);
+		datafileStream.write(reinterpret_cast<const char*>(compressedBytes.data()), compressedBytes.size());
+		return compressedBytes.size();
+	}
+
+	size_t writeBlocks(std::ofstream& datafileStream, std::ifstream& resourceStream, size_t resourceSize, size_t blockSize, uint8_t codec, PackOptions const& options, uint32_t& checksum)
+	{
+		// packs a resource as a table of 64-bit block end offsets (relative to the first block)
+		// followed by blocks of blockSize bytes which are compressed independently
+		// returns the number of bytes written
+		const size_t n_blocks = (resourceSize + blockSize - 1) / blockSize;
+
+		// write a placeholder table, it is overwritten once the blocks are written
+		const std::streampos tableOffset = datafileStream.tellp();
+		T_Bytes tableBytes(n_blocks * sizeof(uint64_t), 0u);
+		datafileStream.write(reinterpret_cast<const char*>(tableBytes.data()), tableBytes.size());
+		tableBytes.clear();
+
+		T_Bytes blockBytes(blockSize);
+		T_Bytes compressedBytes;
+		uint64_t blockEnd = 0;
+		for (size_t i = 0; i < n_blocks; ++i)
+		{
+			const size_t blockRawSize = std::min(blockSize, resourceSize - i * blockSize);
+			resourceStream.read(reinterpret_cast<char*>(blockBytes.data()), blockRawSize);
+			if (static_cast<size_t>(resourceStream.gcount()) != blockRawSize)
+			{
+				throw std::runtime_error("Unable to read data.");
+			}
+
+			checksum = checksumOf(options.chksum, blockBytes.data(), blockRawSize, checksum);
+
+			compressWith(codec, compressedBytes, blockBytes.data(), blockRawSize, options.clevel);
+			datafileStream.write(reinterpret_cast<const char*>(compressedBytes.data()), compressedBytes.size());
+
+			blockEnd += compressedBytes.size();
+			appendBytes(tableBytes, toBytes(toBigEndian(blockEnd)));
+		}
+
+		// write the table
+		const std::streampos endOffset = datafileStream.tellp();
+		datafileStream.seekp(tableOffset);
+		datafileStream.write(reinterpret_cast<const char*>(tableBytes.data()), tableBytes.size());
+		datafileStream.seekp(endOffset);
+
+		return tableBytes.size() + static_cast<size_t>(blockEnd);
+	}
+
 	void pack(Interface& inf, Dict const& dict, std::string const& outputFilename, PackOptions& options)
 	{
 		/*
 
 		Lime datafile structure:
 
-		           Z1    ...   Zn    Zdict
-		          [~~~] [~~~] [~~~] [~~~~~~~~~~]       (zipped content)
+		           Z1    ...   Zn    Zc1  ...  Zck    Zdict
+		          [~~~] [~~~] [~~~] [~~~]     [~~~] [~~~~~~~~~~]       (zipped content)
 
-		   header   user resources   dictionary   end
-		 |________|________________|____________|_____|
+		   header   user resources   category blocks   dictionary   end
+		 |________|________________|_________________|____________|_____|
 
 
 		   Header:
 
-		   bgn   revision-  head*  dict size   dict checksum
-		 |_____|__________|______|___________|...............|
+		   bgn   revision-  head*  dict size   dict raw size   dict checksum
+		 |_____|__________|______|___________|_______________|...............|
 
 
 		   Dictionary:
 
-		   N   category 1   ...   category N
-		 |___|____________|     |____________|
-		            |
-		            |
-		            |
-		         Category:
-
-		         category key*  M   data 1   ...   data M
-		       |______________|___|________|     |________|
+		   flags-  dict id+  N#  category 1   ...   category N
+		 |_______|_________|___|____________|     |____________|
 		                              |
 		                              |
 		                              |
-		                            Data:
+		                           Category:
+
+		         category key*  M#  block offset#  block size#  block raw size#  preset offset#  preset size#  preset raw size#  block checksum
+		       |______________|___|______________|____________|________________|_______________|____________|________________|..............|
+
 
-		                            data key*  seek_id+  size+  checksum
-		                          |__________|_________|______|..........|
+		   Category block:
+
+		   run offset 1   ...   run offset R   data 1   ...   data M
+		 |______________|     |______________|________|     |________|
+		                                           |
+		                                           |
+		                                           |
+		                                         Data:
+
+		   shared length#  suffix length#  key suffix  seek_id delta#  size#  raw size#  block size#  codec-  checksum
+		 |_______________|_______________|___________|_______________|______|__________|____________|________|..........|
+
+		Data records are sorted by key and grouped in runs of LIME_DICT_RUN_LENGTH. Each record
+		shares the first shared length bytes of its key with the previous record of its run, and
+		its seek_id is stored as a zigzag-encoded delta from the end of the previous record of its
+		run (the first record of a run stores it relative to zero). Run offsets are relative to
+		data 1.
+
+		With hashed keys (flags & LIME_DICT_HASHED_KEYS), records are sorted by the 64-bit FNV-1a
+		hash of their key and the key fields are replaced by the hash:
+
+		   key hash+  seek_id delta#  size#  raw size#  block size#  codec-  checksum
+		 |__________|_______________|______|__________|____________|________|..........|
 
 
 		All non-resource strings* are stored in the following manner:
@@ -268,6 +1200,25 @@ namespace Lime
 		Numeric values are stored as 32-bit unsigned integers.
 		Numeric values marked + are stored as 64-bit unsigned integers.
 		Numeric values marked - are stored as 8-bit unsigned integers.
+		Numeric values marked # are stored as varints (unsigned LEB128).
+
+
+		   Resource packed in blocks (non-zero block size):
+
+		   block end 1+  ...  block end K+   Z1    ...   ZK
+		 |_____________|     |_____________|[~~~] [~~~] [~~~]
+
+
+		   LZ sequence (codec 2, lengths marked * continue while bytes are 255):
+
+		   token-  literal count*  literals  offset  match length*
+		 |_______|...............|__________|________|...............|
+
+
+		   Solid group (codec 4, block size holds the member's offset in the group):
+
+		   group raw size   Zgroup
+		 |________________|[~~~~~~]
 
 		*/
 
@@ -303,6 +1254,11 @@ namespace Lime
 				break;
 		}
 
+		if (options.hashKeys)
+		{
+			checkKeyHashes(dict);
+		}
+
 		// prepare header data
 		const uint8_t limeRevision = LIME_REVISION;
 		const std::string* headString = &options.headstr;
@@ -353,10 +1309,12 @@ namespace Lime
 		{
 			// memorize the offset
 			dictPlaceholderOffset = datafileStream.tellp();
-			// both values are 32-bit uint
+			// all values are 32-bit uint
 			T_Bytes dictPlaceholderBytes = toBytes<uint32_t>(0u);
 			// dict size placeholder
 			datafileStream.write(reinterpret_cast<const char*>(dictPlaceholderBytes.data()), dictPlaceholderBytes.size());
+			// dict raw size placeholder
+			datafileStream.write(reinterpret_cast<const char*>(dictPlaceholderBytes.data()), dictPlaceholderBytes.size());
 			// dict checksum placeholder
 			if (options.chksum != ChkSumOption::NONE)
 			{
@@ -365,15 +1323,10 @@ namespace Lime
 		}
 
 		// pack user resources
-		struct DictItemData
-		{
-			size_t offset = 0;
-			uint32_t checksum = 0;
-			size_t size = 0;
-		};
-
 		DMap<DMap<DictItemData>> dictDataMap;
-		std::unordered_map<std::string, DictItemData const*> knownFilenameMap; // used for detecting duplicates
+		std::unordered_map<std::string, PresetData> presetDataMap;
+		DMap<std::vector<SolidMember>> solidGroupMap; // written once all other resources are packed
+		std::unordered_map<std::string, std::pair<std::string, std::string>> knownFilenameMap; // (category, key) of packed files, used for detecting duplicates
 
 		static const size_t inBuffSize = 512u;
 		static const size_t outBuffSize = 16348u;
@@ -389,6 +1342,25 @@ namespace Lime
 			const bool isMeta = (category.length() && category[0] == '@');
 			auto const& collection = it->second;
 
+			std::string const* solidGroup = solidGroupOf(options, category);
+
+			// a trained preset dictionary is written ahead of the category's resources, deflate
+			// streams of the category then start with a window filled with the dictionary
+			uint8_t categoryCodec = codecOf(options, category);
+			T_Bytes preset;
+			if (!solidGroup && categoryCodec == LIME_CODEC_DEFLATE && isCategoryListed(options.presetCategories, category))
+			{
+				preset = trainCategoryPreset(category, collection, options);
+				if (preset.size())
+				{
+					PresetData& presetData = presetDataMap[category];
+					presetData.offset = datafileStream.tellp();
+					presetData.rawSize = preset.size();
+					presetData.size = writeCompressed(datafileStream, preset, options.clevel, "preset dictionary of [" + category + "]");
+					categoryCodec = LIME_CODEC_PRESET;
+				}
+			}
+
 			for (auto it2 = collection.begin(); it2 != collection.end(); ++it2)
 			{
 				auto key = it2->first;
@@ -405,30 +1377,33 @@ namespace Lime
 
 					const size_t offset = datafileStream.tellp();
 
-					uLong dataBytesCompressedSize = compressBound(static_cast<uLong>(data.size()));
-					Bytef* dataBytesCompressedData = new Bytef[dataBytesCompressedSize];
-					if (compress2(dataBytesCompressedData, &dataBytesCompressedSize, (const Bytef*)data.data(), static_cast<uLong>(data.size()), options.clevel) != Z_OK)
+					checksum = checksumOf(options.chksum, reinterpret_cast<const Bytef*>(data.c_str()), data.size());
+
+					// small values of solid categories are packed later, the item keeps its place
+					if (solidGroup && data.size() <= LIME_SOLID_MEMBER_SIZE && !shouldStore(options, std::string()))
 					{
-						// abort packing
-						throw std::runtime_error("Unable to compress data.");
+						dictDataMap[category][key];
+						solidGroupMap[*solidGroup].push_back({ category, key, data, true });
+						continue;
 					}
 
-					datafileStream.write(reinterpret_cast<const char*>(dataBytesCompressedData), dataBytesCompressedSize);
-
 					totalRead += data.size();
 
-					switch (options.chksum)
+					if (shouldStore(options, std::string()))
 					{
-						case ChkSumOption::ADLER32:
-							checksum = adler32_z(0ul, reinterpret_cast<const Bytef*>(data.c_str()), data.size());
-							break;
-						case ChkSumOption::CRC32:
-							checksum = crc32_z(0ul, reinterpret_cast<const Bytef*>(data.c_str()), data.size());
-							break;
+						datafileStream.write(data.data(), data.size());
+						dictDataMap[category][key] = { offset, checksum, data.size(), data.size(), 0u, LIME_CODEC_STORED };
+						continue;
 					}
 
-					// store offset, checksum and size
-					dictDataMap[category][key] = { offset, checksum, static_cast<size_t>(dataBytesCompressedSize) };
+					const uint8_t codec = categoryCodec;
+					T_Bytes compressedBytes;
+					compressWith(codec, compressedBytes, reinterpret_cast<const Bytef*>(data.data()), data.size(), options.clevel, &preset);
+
+					datafileStream.write(reinterpret_cast<const char*>(compressedBytes.data()), compressedBytes.size());
+
+					// store offset, checksum and sizes
+					dictDataMap[category][key] = { offset, checksum, compressedBytes.size(), data.size(), 0u, codec };
 				}
 				else
 				{
@@ -440,18 +1415,30 @@ namespace Lime
 #else
 					std::string const& resFilename = value;
 #endif
+					// small resources of solid categories are packed later, the item keeps its place
+					if (solidGroup && fileSize(resFilename.c_str()) <= LIME_SOLID_MEMBER_SIZE && !shouldStore(options, resFilename))
+					{
+						dictDataMap[category][key];
+						solidGroupMap[*solidGroup].push_back({ category, key, resFilename, false });
+						continue;
+					}
+
 					DictItemData& itemData = dictDataMap[category][key];
 
-					auto knownFilenameIt = knownFilenameMap.find(resFilename);
+					// data packed with a preset dictionary can only be shared within its category
+					const std::string knownFilename = (categoryCodec == LIME_CODEC_PRESET) ? category + '\n' + resFilename : resFilename;
+
+					auto knownFilenameIt = knownFilenameMap.find(knownFilename);
 					if (knownFilenameIt != knownFilenameMap.end())
 					{
 						// we already packed this file
 						// simply reference the same item and skip packing for this item
-						itemData = *knownFilenameIt->second;
+						// (by name, DMap storage moves as items are added)
+						itemData = dictDataMap[knownFilenameIt->second.first][knownFilenameIt->second.second];
 						continue;
 					}
 
-					knownFilenameMap[resFilename] = &itemData;
+					knownFilenameMap[knownFilename] = { category, key };
 
 					size_t totalWritten = 0u;
 
@@ -466,6 +1453,47 @@ namespace Lime
 						throw std::runtime_error("Unable to open file: " + resFilename);
 					}
 
+					const size_t resourceSize = fileSize(resFilename.c_str());
+
+					// resources which are compressed already are copied as is
+					if (shouldStore(options, resFilename))
+					{
+						writeStored(datafileStream, resourceStream, resourceSize, options, checksum);
+						resourceStream.close();
+						totalRead += resourceSize;
+						itemData = { offset, checksum, resourceSize, resourceSize, 0u, LIME_CODEC_STORED };
+						continue;
+					}
+
+					// large resources are packed in blocks which can be inflated separately
+					// (and in parallel); very large resources get blocks unless told otherwise
+					size_t blockSize = options.blockSize;
+					if (blockSize == 0 && options.autoBlockSize && resourceSize > LIME_AUTO_BLOCK_THRESHOLD)
+					{
+						blockSize = LIME_AUTO_BLOCK_SIZE;
+					}
+					// (blocks are compressed without the preset dictionary)
+					const uint8_t codec = categoryCodec;
+					if (blockSize > 0 && resourceSize > blockSize)
+					{
+						const uint8_t blockCodec = (codec == LIME_CODEC_PRESET) ? LIME_CODEC_DEFLATE : codec;
+						totalWritten = writeBlocks(datafileStream, resourceStream, resourceSize, blockSize, blockCodec, options, checksum);
+						resourceStream.close();
+						totalRead += resourceSize;
+						itemData = { offset, checksum, totalWritten, resourceSize, static_cast<uint32_t>(blockSize), blockCodec };
+						continue;
+					}
+
+					// the LZ codec works on whole resources, deflate is streamed below
+					if (codec == LIME_CODEC_LZ)
+					{
+						totalWritten = writeLz(datafileStream, resourceStream, resourceSize, options, checksum);
+						resourceStream.close();
+						totalRead += resourceSize;
+						itemData = { offset, checksum, totalWritten, resourceSize, 0u, codec };
+						continue;
+					}
+
 					z_stream cmpStream;
 					cmpStream.zalloc = Z_NULL;
 					cmpStream.zfree = Z_NULL;
@@ -476,6 +1504,12 @@ namespace Lime
 						throw std::runtime_error("Unable to compress data.");
 					}
 
+					if (codec == LIME_CODEC_PRESET && deflateSetDictionary(&cmpStream, preset.data(), static_cast<uInt>(preset.size())) != Z_OK)
+					{
+						deflateEnd(&cmpStream);
+						throw std::runtime_error("Unable to compress data.");
+					}
+
 					size_t numRead = 0;
 					size_t numReadTotal = 0;
 
@@ -515,15 +1549,7 @@ namespace Lime
 
 						} while (cmpStream.avail_out == 0);
 
-						switch (options.chksum)
-						{
-							case ChkSumOption::ADLER32:
-								checksum = adler32_z(checksum, inputBuffer, numRead);
-								break;
-							case ChkSumOption::CRC32:
-								checksum = crc32_z(checksum, inputBuffer, numRead);
-								break;
-						}
+						checksum = checksumOf(options.chksum, inputBuffer, numRead, checksum);
 
 					} while (!isEof);
 
@@ -538,19 +1564,27 @@ namespace Lime
 
 					totalRead += numReadTotal;
 
-					// store offset, checksum and size
-					itemData = { offset, checksum, totalWritten };
+					// store offset, checksum and sizes
+					itemData = { offset, checksum, totalWritten, numReadTotal, 0u, codec };
 				}
 			}
 		}
 		delete[] inputBuffer;
 		delete[] outputBuffer;
 
-		// create the dictionary binary
+		writeSolidGroups(datafileStream, solidGroupMap, dictDataMap, options, totalRead);
+
+		// create the category blocks and the dictionary binary
+		// each category's lookup table is compressed into a separate block which Unlime
+		// only inflates when the category is first accessed
 		T_Bytes dictBytes;
 
-		uint32_t N_categories = static_cast<uint32_t>(dictDataMap.size());
-		appendBytes(dictBytes, toBytes(toBigEndian(N_categories)));
+		// the dict id is a hash of all category blocks and records, it identifies the dictionary
+		// for the resource ids of lime -header
+		T_Bytes categoryBytes;
+		uint64_t dictId = hashBytes(nullptr, 0u);
+
+		appendVarint(categoryBytes, dictDataMap.size());
 
 		for (auto const& it : dictDataMap)
 		{
@@ -564,65 +1598,64 @@ namespace Lime
 				categoryKey.erase(0, 1);
 			}
 
-			uint8_t categoryKeySize = static_cast<uint8_t>(categoryKey.size());
-			appendBytes(dictBytes, toBytes(toBigEndian(categoryKeySize)));
-			appendBytes(dictBytes, categoryKey);
+			const T_Bytes blockBytes = buildCategoryBlock(collection, options);
+			dictId = hashBytes(blockBytes.data(), blockBytes.size(), dictId);
 
-			uint32_t M_keys = static_cast<uint32_t>(collection.size());
-			appendBytes(dictBytes, toBytes(toBigEndian(M_keys)));
+			// compress and write the category block
+			const uint64_t blockOffset = static_cast<uint64_t>(datafileStream.tellp());
+			const uint32_t blockRawSize = static_cast<uint32_t>(blockBytes.size());
+			const uint32_t blockChecksum = checksumOf(options.chksum, blockBytes);
+			const uint32_t blockSize = static_cast<uint32_t>(writeCompressed(datafileStream, blockBytes, options.clevel, "category block of [" + it.first + "]"));
 
-			for (auto const& it2 : collection)
+			// add the category to the dictionary
+			uint8_t categoryKeySize = static_cast<uint8_t>(categoryKey.size());
+			appendBytes(categoryBytes, toBytes(toBigEndian(categoryKeySize)));
+			appendBytes(categoryBytes, categoryKey);
+
+			appendVarint(categoryBytes, collection.size());
+			appendVarint(categoryBytes, blockOffset);
+			appendVarint(categoryBytes, blockSize);
+			appendVarint(categoryBytes, blockRawSize);
+
+			// categories without a preset dictionary have a preset size of zero
+			PresetData presetData;
+			auto presetDataIt = presetDataMap.find(it.first);
+			if (presetDataIt != presetDataMap.end())
 			{
-				auto const& collectionKey = it2.first;
-				auto const& itemData = it2.second;
-
-				uint8_t collectionKeySize = static_cast<uint8_t>(collectionKey.size());
-				appendBytes(dictBytes, toBytes(toBigEndian(collectionKeySize)));
-				appendBytes(dictBytes, collectionKey);
-				
-				uint64_t seek_id = static_cast<uint64_t>(itemData.offset);
-				appendBytes(dictBytes, toBytes(toBigEndian(seek_id)));
-
-				uint64_t resourceSize = static_cast<uint64_t>(itemData.size);
-				appendBytes(dictBytes, toBytes(toBigEndian(resourceSize)));
+				presetData = presetDataIt->second;
+			}
+			appendVarint(categoryBytes, presetData.offset);
+			appendVarint(categoryBytes, presetData.size);
+			appendVarint(categoryBytes, presetData.rawSize);
 
-				if (options.chksum != ChkSumOption::NONE)
-				{
-					uint32_t const& checksum = itemData.checksum;
-					appendBytes(dictBytes, toBytes(toBigEndian(checksum)));
-				}
+			if (options.chksum != ChkSumOption::NONE)
+			{
+				appendBytes(categoryBytes, toBytes(toBigEndian(blockChecksum)));
 			}
 		}
 
-		// calculate dict checksum
-		uint32_t dictChecksum = 0;
-		switch (options.chksum)
+		dictId = hashBytes(categoryBytes.data(), categoryBytes.size(), dictId);
+		if (dictId == 0)
 		{
-			case ChkSumOption::ADLER32:
-				dictChecksum = adler32_z(0ul, dictBytes.data(), dictBytes.size());
-				break;
-			case ChkSumOption::CRC32:
-				dictChecksum = crc32_z(0ul, dictBytes.data(), dictBytes.size());
-				break;
+			// zero is left for resource ids without a dict id
+			dictId = 1;
 		}
 
-		// compress dictionary binary
+		const uint8_t dictFlags = options.hashKeys ? LIME_DICT_HASHED_KEYS : 0u;
+		appendBytes(dictBytes, toBytes(toBigEndian(dictFlags)));
+		appendBytes(dictBytes, toBytes(toBigEndian(dictId)));
+		appendBytes(dictBytes, categoryBytes);
 
-		uLong dictBytesCompressedSize = compressBound(static_cast<uLong>(dictBytes.size()));
-		Bytef* dictBytesCompressedData = new Bytef[dictBytesCompressedSize];
-		
-		if (compress2(dictBytesCompressedData, &dictBytesCompressedSize, dictBytes.data(), static_cast<uLong>(dictBytes.size()), options.clevel) != Z_OK)
-		{
-			delete[] dictBytesCompressedData;
-			throw std::runtime_error("Unable to compress dictionary.");
-		}
+		// calculate dict checksum
+		const uint32_t dictChecksum = checksumOf(options.chksum, dictBytes);
+
+		// compress and write dictionary binary
+		const size_t dictBytesRawSize = dictBytes.size();
+		const size_t dictBytesCompressedSize = writeCompressed(datafileStream, dictBytes, options.clevel, "dictionary");
 
 		// we can now dispose of uncompressed dict bytes
 		dictBytes.clear();
 
-		// write dictionary
-		datafileStream.write(reinterpret_cast<const char*>(dictBytesCompressedData), static_cast<size_t>(dictBytesCompressedSize));
-
 		// end endpoint
 		if (endEndpoint)
 		{
@@ -636,6 +1669,11 @@ namespace Lime
 			T_Bytes dictSizeBytes = toBytes(toBigEndian(dictSize));
 			datafileStream.write(reinterpret_cast<const char*>(dictSizeBytes.data()), dictSizeBytes.size());
 		}
+		{
+			const uint32_t dictRawSize = static_cast<uint32_t>(dictBytesRawSize);
+			T_Bytes dictRawSizeBytes = toBytes(toBigEndian(dictRawSize));
+			datafileStream.write(reinterpret_cast<const char*>(dictRawSizeBytes.data()), dictRawSizeBytes.size());
+		}
 		if (options.chksum != ChkSumOption::NONE)
 		{
 			T_Bytes dictChecksumBytes = toBytes(toBigEndian(dictChecksum));
@@ -645,9 +1683,6 @@ namespace Lime
 		// all done
 		datafileStream.close();
 
-		// cleanup
-		delete[] dictBytesCompressedData;
-
 		// writing successful, print out some statistics
 		size_t totalDataSize = fileSize(outputFilename.c_str());
 		const float compressionRatio = (1.f - totalDataSize * 1.f / totalRead) * 100.f;
@@ -661,5 +1696,13 @@ namespace Lime
 		inf.ok("done")
 			<< "\n\nRead " << totalRead << " bytes, wrote " << totalDataSize << " bytes.\n"
 			<< "Compression ratio: " << compressionRatioStr << "%\n";
+
+		// write resource IDs
+		if (!options.headerFilename.empty())
+		{
+			inf << "\nWriting resource header: " << options.headerFilename << " ... ";
+			writeResourceHeader(options.headerFilename, outputFilename, dictDataMap, options.hashKeys, dictId);
+			inf.ok("done") << "\n";
+		}
 	}
 }
@@ -36,6 +36,8 @@
 #define LIME_PACK_H_
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "dict.h"
 #include "interface.h"
 
@@ -46,11 +48,24 @@ namespace Lime
 		ADLER32, CRC32, NONE
 	};
 
+	enum class StoreOption : unsigned char
+	{
+		AUTO, ALL, NONE
+	};
+
 	struct PackOptions
 	{
 		unsigned char clevel = 9;
 		ChkSumOption chksum = ChkSumOption::ADLER32;
 		std::string headstr;
+		std::string headerFilename;
+		size_t blockSize = 0; // resources larger than this are packed in blocks, 0 disables blocks
+		bool autoBlockSize = true; // with no block size set, packs very large resources in blocks
+		StoreOption store = StoreOption::AUTO; // which resources are stored without compression
+		std::vector<std::string> lzCategories; // categories packed with the LZ codec instead of deflate, * for all
+		std::vector<std::string> presetCategories; // categories which get a trained preset dictionary, * for all
+		std::unordered_map<std::string, std::string> solidGroups; // category -> solid group (manifest section [!solid])
+		bool hashKeys = false; // category blocks hold 64-bit key hashes instead of keys
 	};
 
 	void pack(Interface& inf, Dict const& resourceDict, std::string const& outputFilename, PackOptions& options);
@@ -36,13 +36,40 @@
 #undef UNLIME_PHONY
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
 #include <exception>
-#include <fstream>
 #include <cstdint>
+#include <climits>
+#include <limits>
+#include <cerrno>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <deque>
+#include <list>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <chrono>
 #include <zlib.h>
+#if defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <pthread.h>
+	#include <sched.h>
+#endif
 
 class Unlime
 {
@@ -115,15 +142,107 @@ public:
 
 	using T_Bytes = std::vector<Bytef>;
 
+	struct Query
+	{
+		std::string category;
+		std::string key;
+		T_Bytes* data = nullptr;
+		bool found = false;
+	};
+
+	struct AsyncResult
+	{
+		bool found = false;
+		T_Bytes data;
+	};
+
+	using T_AsyncHandle = std::future<AsyncResult>;
+
+	// how item data is stored in the datafile
+	enum class Codec : unsigned char
+	{
+		DEFLATE, // zlib stream
+		STORED,  // uncompressed
+		LZ,      // built-in LZ codec, decodes faster than deflate (lime -lz)
+		PRESET,  // zlib stream deflated with the category's preset dictionary (lime -preset)
+		SOLID    // member of a solid group, several small items inflated as one (manifest section [!solid])
+	};
+
+	// item data exactly as stored in the datafile, see Extractor::getRaw
+	struct RawData
+	{
+		T_Bytes data;
+		Codec codec = Codec::DEFLATE;
+		uint64_t rawSize = 0;   // size of the data once inflated
+		uint32_t blockSize = 0; // non-zero if packed in blocks (lime -blocksize)
+		uint32_t solidOffset = 0; // offset of the item in the inflated group for Codec::SOLID, see format.txt
+		uint32_t checksum = 0;  // checksum of the inflated data, zero if the datafile has none
+		T_Bytes const* preset = nullptr; // dictionary to inflate Codec::PRESET data with, valid until dropDict() is called
+	};
+
+	// item data in the memory mapping, see Extractor::view
+	struct DataView
+	{
+		Bytef const* data = nullptr;
+		size_t size = 0;
+	};
+
+	class Extractor;
+
+	// resource identifier resolved at compile time, see lime -header
+	// category and item are indices into the datafile dictionary
+	struct ResourceId
+	{
+		uint32_t category = 0;
+		uint32_t item = 0;
+		std::string_view categoryName;
+		std::string_view keyName;
+		uint64_t size = 0;
+		uint64_t dictId = 0; // fingerprint of the dictionary the indices belong to
+	};
+
+	struct CacheStats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		size_t size = 0;
+		size_t n_items = 0;
+	};
+
+	// when checksums are tested (see Options::integrityPolicy)
+	enum class IntegrityPolicy : unsigned char
+	{
+		ALWAYS,       // on every extraction
+		FIRST_ACCESS, // on the first extraction of each item
+		SAMPLED,      // on one in every Options::integritySampleRate extractions
+		SCRUB         // on a background thread which verifies the whole datafile once
+	};
+
+	enum class ScrubState : unsigned char
+	{
+		IDLE, RUNNING, PASSED, FAILED
+	};
+
 	struct Options
 	{
 		bool integrityCheck = true;
+		IntegrityPolicy integrityPolicy = IntegrityPolicy::ALWAYS;
+		size_t integritySampleRate = 16;
 		bool checkHeadString = false;
 		std::string headString;
+		bool memoryMap = false;
+		size_t threadCount = 0;
+		size_t cacheSize = 0;
+		std::vector<std::string> residentCategories;
+		bool lazyDict = true;
+		size_t readBufferSize = 16u * 1024u;
+		size_t batchReadSize = 4u * 1024u * 1024u;
+		bool parallelInflate = true;
 	};
 
 private:
-	const uint8_t LIME_REVISION = 1;
+	const uint8_t LIME_REVISION = 2;
+	const uint8_t LIME_DICT_HASHED_KEYS = 1u;
 
 	const std::string LM_BGN_ADLER32 = "L>";
 	const std::string LM_END_ADLER32 = "<M";
@@ -141,316 +260,2369 @@ private:
 
 	const uint64_t minimumDatafileSize = 36u;
 
-	const std::string datafileFilename;
+	// work-stealing thread pool used for asynchronous extraction
+	class WorkerPool
+	{
+	private:
+		using T_Task = std::function<void()>;
 
-	Options options;
+		struct Worker
+		{
+			std::deque<T_Task> tasks;
+			std::mutex mutex;
+		};
 
-	struct T_DictItem
-	{
-		uint64_t seek_id = 0;
-		uint64_t size = 0;
-		uint32_t checksum = 0;
-	};
-	using T_DictCategory = std::unordered_map<std::string, T_DictItem>;
-	using T_DictMap = std::unordered_map<std::string, T_DictCategory>;
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::vector<std::thread> threads;
 
-	T_DictMap dictMap;
-	bool dictWasRead = false;
+		std::mutex wakeMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<size_t> n_queued { 0 };
+		std::atomic<size_t> nextWorker { 0 };
+		bool stopping = false;
 
-	uint64_t totalDatafileSize = 0;
+		bool popTask(size_t index, T_Task& task)
+		{
+			const size_t n_workers = workers.size();
+			// take the newest task from our own queue, otherwise steal the oldest task of another worker
+			for (size_t i = 0; i < n_workers; ++i)
+			{
+				Worker& worker = *workers[(index + i) % n_workers];
+				std::lock_guard<std::mutex> lock(worker.mutex);
+				if (worker.tasks.empty())
+				{
+					continue;
+				}
+				if (i == 0)
+				{
+					task = std::move(worker.tasks.back());
+					worker.tasks.pop_back();
+				}
+				else
+				{
+					task = std::move(worker.tasks.front());
+					worker.tasks.pop_front();
+				}
+				--n_queued;
+				return true;
+			}
+			return false;
+		}
 
-	DatafileChecksumFunc chksumFunc = DatafileChecksumFunc::ADLER32;
+		void run(size_t index)
+		{
+			for (;;)
+			{
+				T_Task task;
+				if (popTask(index, task))
+				{
+					task();
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(wakeMutex);
+				wakeCondition.wait(lock, [this]() { return stopping || n_queued > 0; });
+				if (stopping && n_queued == 0)
+				{
+					return;
+				}
+			}
+		}
 
-	uint32_t dictSize = 0;
-	uint32_t dictChecksum = 0;
-	uint64_t dictOffset = 0;
+		WorkerPool(WorkerPool const&) = delete;
+		WorkerPool& operator=(WorkerPool const&) = delete;
 
-	bool wasValidated = false;
+	public:
+		WorkerPool(size_t n_threads)
+		{
+			if (n_threads == 0)
+			{
+				n_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			for (size_t i = 0; i < n_threads; ++i)
+			{
+				workers.push_back(std::make_unique<Worker>());
+			}
+			for (size_t i = 0; i < n_threads; ++i)
+			{
+				threads.emplace_back(&WorkerPool::run, this, i);
+			}
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(wakeMutex);
+				stopping = true;
+			}
+			wakeCondition.notify_all();
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		}
 
-	std::ifstream datafileStream;
+		size_t size() const
+		{
+			return threads.size();
+		}
 
-	size_t n_extractors = 0;
+		void submit(T_Task task)
+		{
+			Worker& worker = *workers[nextWorker++ % workers.size()];
+			{
+				std::lock_guard<std::mutex> lock(worker.mutex);
+				worker.tasks.push_back(std::move(task));
+			}
+			++n_queued;
+			{
+				std::lock_guard<std::mutex> lock(wakeMutex);
+			}
+			wakeCondition.notify_one();
+		}
+	};
 
-	void openDatafile()
+	// size-bounded LRU cache of decompressed items, keyed by the item's seek_id (see isCached)
+	class ResourceCache
 	{
-		if (datafileStream.is_open())
+	public:
+		using T_CachedBytes = std::shared_ptr<const T_Bytes>;
+
+	private:
+		struct CacheItem
 		{
-			return;
+			T_CachedBytes data;
+			std::list<uint64_t>::iterator lruIt;
+			bool isPinned = false;
+		};
+
+		const size_t budget = 0;
+		size_t usedBytes = 0;
+
+		std::unordered_map<uint64_t, CacheItem> items;
+		std::list<uint64_t> lruList; // most recently used first, pinned items are not listed
+		std::mutex mutex;
+
+		std::atomic<uint64_t> n_hits { 0 };
+		std::atomic<uint64_t> n_misses { 0 };
+
+		void evict()
+		{
+			while (usedBytes > budget && !lruList.empty())
+			{
+				auto it = items.find(lruList.back());
+				usedBytes -= it->second.data->size();
+				items.erase(it);
+				lruList.pop_back();
+			}
 		}
-		datafileStream.open(datafileFilename, std::ios::in | std::ifstream::binary);
-		if (!datafileStream.is_open())
+
+	public:
+		ResourceCache(size_t budget = 0)
+		: budget(budget)
 		{
-			throw Exception::UnableToOpen(datafileFilename);
 		}
-	}
 
-	void closeDatafile()
+		bool isEnabled() const
+		{
+			return budget > 0;
+		}
+
+		bool fetch(uint64_t id, T_Bytes& destination)
+		{
+			T_CachedBytes data;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = items.find(id);
+				if (it == items.end())
+				{
+					++n_misses;
+					return false;
+				}
+				CacheItem& item = it->second;
+				if (!item.isPinned)
+				{
+					lruList.splice(lruList.begin(), lruList, item.lruIt);
+				}
+				data = item.data;
+			}
+			++n_hits;
+			// copy outside of the lock
+			destination.assign(data->begin(), data->end());
+			return true;
+		}
+
+		// same as fetch but shares the cached data instead of copying it, nullptr if not cached
+		T_CachedBytes fetchShared(uint64_t id)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = items.find(id);
+			if (it == items.end())
+			{
+				++n_misses;
+				return nullptr;
+			}
+			CacheItem& item = it->second;
+			if (!item.isPinned)
+			{
+				lruList.splice(lruList.begin(), lruList, item.lruIt);
+			}
+			++n_hits;
+			return item.data;
+		}
+
+		void store(uint64_t id, T_Bytes const& data, bool pin = false)
+		{
+			if (data.size() > budget && !pin)
+			{
+				return;
+			}
+			store(id, std::make_shared<const T_Bytes>(data), pin);
+		}
+
+		void store(uint64_t id, T_CachedBytes cachedData, bool pin = false)
+		{
+			if (cachedData->size() > budget && !pin)
+			{
+				return;
+			}
+			const size_t dataSize = cachedData->size();
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = items.find(id);
+			if (it != items.end())
+			{
+				if (pin && !it->second.isPinned)
+				{
+					lruList.erase(it->second.lruIt);
+					it->second.isPinned = true;
+				}
+				return;
+			}
+			CacheItem& item = items[id];
+			item.data = std::move(cachedData);
+			item.isPinned = pin;
+			if (!pin)
+			{
+				lruList.push_front(id);
+				item.lruIt = lruList.begin();
+			}
+			usedBytes += dataSize;
+			evict();
+		}
+
+		// returns false if the item is not cached
+		bool pin(uint64_t id)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = items.find(id);
+			if (it == items.end())
+			{
+				return false;
+			}
+			if (!it->second.isPinned)
+			{
+				lruList.erase(it->second.lruIt);
+				it->second.isPinned = true;
+			}
+			return true;
+		}
+
+		void unpin(uint64_t id)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = items.find(id);
+			if (it == items.end() || !it->second.isPinned)
+			{
+				return;
+			}
+			it->second.isPinned = false;
+			lruList.push_front(id);
+			it->second.lruIt = lruList.begin();
+			evict();
+		}
+
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			items.clear();
+			lruList.clear();
+			usedBytes = 0;
+		}
+
+		CacheStats stats()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			CacheStats cacheStats;
+			cacheStats.hits = n_hits;
+			cacheStats.misses = n_misses;
+			cacheStats.size = usedBytes;
+			cacheStats.n_items = items.size();
+			return cacheStats;
+		}
+	};
+
+	// 64-bit FNV-1a
+	static uint64_t hashKey(std::string_view key)
 	{
-		if (datafileStream.is_open())
+		uint64_t value = 14695981039346656037ull;
+		for (char c : key)
 		{
-			datafileStream.close();
+			value ^= static_cast<unsigned char>(c);
+			value *= 1099511628211ull;
 		}
+		return value;
 	}
 
+	// flat string-keyed index: keys live in a single arena and are found through an
+	// open-addressing table (linear probing, load factor at most 1/2), values are stored
+	// contiguously and never move once the index was built
+	template<class T_Value>
+	class FlatIndex
+	{
+	private:
+		struct Entry
+		{
+			T_Value value;
+			uint32_t keyOffset = 0;
+			uint32_t keyLength = 0;
+		};
+
+		struct Slot
+		{
+			uint32_t hashTag = 0;
+			uint32_t entry = 0; // entry index + 1, zero marks an empty slot
+		};
+
+		std::vector<Entry> entries;
+		std::vector<Slot> slots;
+		std::string arena;
+		size_t mask = 0;
+
+		std::string_view keyOf(Entry const& entry) const
+		{
+			return std::string_view(arena.data() + entry.keyOffset, entry.keyLength);
+		}
+
+	public:
+		// prepares room for n_entries values; arenaSize is a hint for the total key length
+		void reset(size_t n_entries, size_t arenaSize = 0)
+		{
+			size_t n_slots = 2;
+			while (n_slots < n_entries * 2)
+			{
+				n_slots <<= 1;
+			}
+			entries = std::vector<Entry>(n_entries);
+			slots.assign(n_slots, Slot());
+			mask = n_slots - 1;
+			arena.clear();
+			arena.reserve(arenaSize);
+		}
+
+		void clear()
+		{
+			entries = std::vector<Entry>();
+			slots = std::vector<Slot>();
+			arena = std::string();
+			mask = 0;
+		}
+
+		size_t size() const
+		{
+			return entries.size();
+		}
+
+		T_Value& at(size_t i)
+		{
+			return entries[i].value;
+		}
+
+		T_Value const& at(size_t i) const
+		{
+			return entries[i].value;
+		}
+
+		std::string_view keyAt(size_t i) const
+		{
+			return keyOf(entries[i]);
+		}
+
+		// stores the key of entry i and returns its value for filling in, nullptr if another
+		// entry has the same key
+		T_Value* set(size_t i, std::string_view key)
+		{
+			const uint64_t keyHash = hashKey(key);
+			const uint32_t hashTag = static_cast<uint32_t>(keyHash >> 32);
+			size_t slot = static_cast<size_t>(keyHash) & mask;
+			while (slots[slot].entry != 0)
+			{
+				if (slots[slot].hashTag == hashTag && keyOf(entries[slots[slot].entry - 1]) == key)
+				{
+					return nullptr;
+				}
+				slot = (slot + 1) & mask;
+			}
+
+			Entry& entry = entries[i];
+			entry.keyOffset = static_cast<uint32_t>(arena.size());
+			entry.keyLength = static_cast<uint32_t>(key.size());
+			arena.append(key.data(), key.size());
+			slots[slot].hashTag = hashTag;
+			slots[slot].entry = static_cast<uint32_t>(i + 1);
+			return &entry.value;
+		}
+
+		T_Value const* find(std::string_view key) const
+		{
+			if (slots.empty())
+			{
+				return nullptr;
+			}
+			const uint64_t keyHash = hashKey(key);
+			const uint32_t hashTag = static_cast<uint32_t>(keyHash >> 32);
+			size_t slot = static_cast<size_t>(keyHash) & mask;
+			while (slots[slot].entry != 0)
+			{
+				if (slots[slot].hashTag == hashTag)
+				{
+					Entry const& entry = entries[slots[slot].entry - 1];
+					if (keyOf(entry) == key)
+					{
+						return &entry.value;
+					}
+				}
+				slot = (slot + 1) & mask;
+			}
+			return nullptr;
+		}
+
+		T_Value* find(std::string_view key)
+		{
+			return const_cast<T_Value*>(static_cast<FlatIndex const*>(this)->find(key));
+		}
+	};
+
+	// reads an unsigned LEB128 varint from bytes (which end at end) into value, which it
+	// has to fit
 	template<class T>
-	void readValueFromStream(T& value)
+	static void readVarint(T& value, T_Bytes const& bytes, size_t& at, size_t end)
 	{
-		value = 0;
-		size_t n_bytes = sizeof(T);
-		for (size_t i = 0; i < n_bytes; ++i)
+		uint64_t result = 0;
+		for (unsigned shift = 0;; shift += 7)
 		{
-			Bytef buffer;
-			datafileStream.read((char*)&buffer, 1);
-			value = (value << 8) + buffer;
+			if (at >= end || shift > 63)
+			{
+				throw Exception::CorruptedFile();
+			}
+			const Bytef byte = bytes[at++];
+			result |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+			if ((byte & 0x80u) == 0)
+			{
+				break;
+			}
+		}
+		if (result > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+		{
+			throw Exception::CorruptedFile();
 		}
+		value = static_cast<T>(result);
 	}
 
-	template<class T>
-	void readValueFromBytes(T& value, T_Bytes const& bytes, size_t& at)
+	const std::string datafileFilename;
+
+	Options options;
+
+	struct T_DictItem
 	{
-		value = 0;
-		size_t n_bytes = sizeof(T);
-		for (size_t i = 0; i < n_bytes; ++i)
+		uint64_t seek_id = 0;
+		uint64_t size = 0;
+		uint64_t rawSize = 0;
+		uint32_t blockSize = 0; // zero unless the item is packed in blocks
+		uint32_t solidOffset = 0; // offset of the item in the inflated group for Codec::SOLID
+		Codec codec = Codec::DEFLATE;
+		uint32_t checksum = 0;
+		T_Bytes const* preset = nullptr; // preset dictionary of the item's category (Codec::PRESET)
+		mutable std::atomic<bool> isVerified { false };
+	};
+
+	// data records of a category exactly as laid out by lime (see format.txt): run offsets
+	// followed by records sorted by key, front-coded in runs of runLength (or sorted by key
+	// hash with hashed keys); lookups search the block itself and a run is only decoded into
+	// T_DictItems when it is first used
+	class ItemTable
+	{
+	private:
+		static constexpr size_t runLength = 16u;
+		static constexpr size_t runOffsetSize = 4u;
+
+		struct Run
 		{
-			value = (value << 8) + bytes[at + i];
+			std::atomic<T_DictItem*> items { nullptr };
+			std::unique_ptr<T_DictItem[]> storage;
+		};
+
+		// key of a record as stored: the length it shares with the previous key of its run
+		// and the rest of it (in the table), or its hash with hashed keys
+		struct RecordKey
+		{
+			size_t sharedLength = 0;
+			std::string_view suffix;
+			uint64_t hash = 0;
+
+			size_t length() const
+			{
+				return sharedLength + suffix.size();
+			}
+		};
+
+		T_Bytes table;
+		size_t n_items = 0;
+		size_t n_runs = 0;
+		size_t recordsAt = 0;
+		bool hasChecksums = false;
+		bool hasHashedKeys = false;
+		T_Bytes const* preset = nullptr;
+		std::unique_ptr<Run[]> runs;
+		std::mutex decodeMutex;
+
+		// returns the bounds of run r within the table
+		std::pair<size_t, size_t> rangeOf(size_t r) const
+		{
+			const size_t begin = recordsAt + runOffsetAt(r);
+			const size_t end = (r + 1 < n_runs) ? recordsAt + runOffsetAt(r + 1) : table.size();
+			if (begin > end || end > table.size())
+			{
+				throw Exception::CorruptedFile();
+			}
+			return { begin, end };
+		}
+
+		size_t runOffsetAt(size_t r) const
+		{
+			return valueAt<uint32_t>(r * runOffsetSize);
+		}
+
+		template<class T>
+		T valueAt(size_t at) const
+		{
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); ++i)
+			{
+				value = (value << 8) + table[at + i];
+			}
+			return value;
+		}
+
+		// reads the record at at (ending before end) into dictItem and its key into key, which
+		// holds the previous key of the run; previousEnd is the end of the previous record in
+		// the run and is advanced past this one
+		void readRecord(size_t& at, size_t end, RecordKey& key, uint64_t& previousEnd, T_DictItem& dictItem) const
+		{
+			if (hasHashedKeys)
+			{
+				if (end - at < 8u)
+				{
+					throw Exception::CorruptedFile();
+				}
+				key.hash = valueAt<uint64_t>(at);
+				at += 8u;
+			}
+			else
+			{
+				readKey(at, end, key);
+			}
+
+			uint64_t seekDelta = 0;
+			readVarint(seekDelta, table, at, end);
+			dictItem.seek_id = previousEnd + ((seekDelta >> 1) ^ (~(seekDelta & 1u) + 1u));
+			readVarint(dictItem.size, table, at, end);
+			readVarint(dictItem.rawSize, table, at, end);
+			readVarint(dictItem.blockSize, table, at, end);
+			if (at >= end)
+			{
+				throw Exception::CorruptedFile();
+			}
+			const uint8_t codec = table[at++];
+			if (codec > static_cast<uint8_t>(Codec::SOLID)
+				|| (codec == static_cast<uint8_t>(Codec::STORED) && (dictItem.blockSize != 0 || dictItem.size != dictItem.rawSize))
+				|| (codec == static_cast<uint8_t>(Codec::PRESET) && (dictItem.blockSize != 0 || preset->empty())))
+			{
+				throw Exception::CorruptedFile();
+			}
+			dictItem.codec = static_cast<Codec>(codec);
+			dictItem.preset = preset;
+			if (dictItem.codec == Codec::SOLID)
+			{
+				// members of solid groups keep their offset in the group in the block size field
+				dictItem.solidOffset = dictItem.blockSize;
+				dictItem.blockSize = 0;
+			}
+			if (hasChecksums)
+			{
+				if (end - at < 4u)
+				{
+					throw Exception::CorruptedFile();
+				}
+				dictItem.checksum = valueAt<uint32_t>(at);
+				at += 4u;
+			}
+			previousEnd = dictItem.seek_id + dictItem.size;
+		}
+
+		// reads a front-coded key, key holds the previous key of the run
+		void readKey(size_t& at, size_t end, RecordKey& key) const
+		{
+			size_t sharedLength = 0;
+			size_t suffixLength = 0;
+			readVarint(sharedLength, table, at, end);
+			readVarint(suffixLength, table, at, end);
+			if (sharedLength > key.length() || suffixLength > end - at)
+			{
+				throw Exception::CorruptedFile();
+			}
+			key.sharedLength = sharedLength;
+			key.suffix = std::string_view(reinterpret_cast<const char*>(table.data() + at), suffixLength);
+			at += suffixLength;
+		}
+
+		// length of the prefix a record's key has in common with key, given the length matched
+		// the previous key of the run has in common with it; keys are compared in place as
+		// the previous key is not kept (front coding shares the longest common prefix)
+		static size_t matchedLength(RecordKey const& recordKey, size_t matched, std::string_view key)
+		{
+			if (recordKey.sharedLength != matched)
+			{
+				return std::min(recordKey.sharedLength, matched);
+			}
+			size_t length = matched;
+			while (length < recordKey.length() && length < key.size() && recordKey.suffix[length - recordKey.sharedLength] == key[length])
+			{
+				++length;
+			}
+			return length;
+		}
+
+		// orders a record's key against key (negative if it comes first), matched is the
+		// prefix they have in common and the previous key of the run comes before key
+		static int compareKeys(RecordKey const& recordKey, size_t matched, std::string_view key)
+		{
+			if (matched == recordKey.length())
+			{
+				return (matched == key.size()) ? 0 : -1;
+			}
+			if (matched == key.size())
+			{
+				return 1;
+			}
+			if (matched < recordKey.sharedLength)
+			{
+				// the keys differ where the record's key equals the previous one
+				return -1;
+			}
+			const unsigned char recordChar = static_cast<unsigned char>(recordKey.suffix[matched - recordKey.sharedLength]);
+			return (recordChar < static_cast<unsigned char>(key[matched])) ? -1 : 1;
+		}
+
+		size_t runSize(size_t r) const
+		{
+			return std::min(runLength, n_items - r * runLength);
+		}
+
+		T_DictItem* decode(size_t r)
+		{
+			Run& run = runs[r];
+			std::lock_guard<std::mutex> lock(decodeMutex);
+			T_DictItem* items = run.items.load(std::memory_order_relaxed);
+			if (items)
+			{
+				return items;
+			}
+			auto storage = std::make_unique<T_DictItem[]>(runSize(r));
+			auto range = rangeOf(r);
+			RecordKey key;
+			uint64_t previousEnd = 0;
+			for (size_t j = 0; j < runSize(r); ++j)
+			{
+				readRecord(range.first, range.second, key, previousEnd, storage[j]);
+			}
+			run.storage = std::move(storage);
+			run.items.store(run.storage.get(), std::memory_order_release);
+			return run.storage.get();
+		}
+
+		// the first key of a run is stored whole
+		std::string_view firstKeyOf(size_t r) const
+		{
+			auto range = rangeOf(r);
+			size_t at = range.first;
+			size_t sharedLength = 0;
+			size_t keyLength = 0;
+			readVarint(sharedLength, table, at, range.second);
+			readVarint(keyLength, table, at, range.second);
+			if (sharedLength != 0 || keyLength > range.second - at)
+			{
+				throw Exception::CorruptedFile();
+			}
+			return std::string_view(reinterpret_cast<const char*>(table.data() + at), keyLength);
+		}
+
+		uint64_t firstKeyHashOf(size_t r) const
+		{
+			auto range = rangeOf(r);
+			if (range.second - range.first < 8u)
+			{
+				throw Exception::CorruptedFile();
+			}
+			return valueAt<uint64_t>(range.first);
+		}
+
+		// binary search for the last run whose first key is not past the key (see find)
+		template<class T_Key, class T_FirstKeyOf>
+		size_t runAfter(T_Key const& key, T_FirstKeyOf firstKeyOf) const
+		{
+			size_t first = 0;
+			size_t count = n_runs;
+			while (count > 0)
+			{
+				const size_t step = count / 2;
+				if (!(key < firstKeyOf(first + step)))
+				{
+					first += step + 1;
+					count -= step + 1;
+				}
+				else
+				{
+					count = step;
+				}
+			}
+			return first;
+		}
+
+	public:
+		// takes over an inflated category block of n_items records, checking that its run
+		// offsets are in bounds; preset is the category's preset dictionary (empty if it has none)
+		void reset(T_Bytes&& tableBytes, size_t n_items, bool hasChecksums, bool hasHashedKeys, T_Bytes const* preset)
+		{
+			table = std::move(tableBytes);
+			this->n_items = n_items;
+			this->hasChecksums = hasChecksums;
+			this->hasHashedKeys = hasHashedKeys;
+			this->preset = preset;
+			n_runs = (n_items + runLength - 1) / runLength;
+			recordsAt = n_runs * runOffsetSize;
+			if (recordsAt > table.size())
+			{
+				throw Exception::CorruptedFile();
+			}
+			runs = std::make_unique<Run[]>(n_runs);
+		}
+
+		void clear()
+		{
+			table = T_Bytes();
+			runs.reset();
+			n_items = 0;
+			n_runs = 0;
+		}
+
+		size_t size() const
+		{
+			return n_items;
+		}
+
+		T_DictItem const& at(size_t i)
+		{
+			const size_t r = i / runLength;
+			T_DictItem* items = runs[r].items.load(std::memory_order_acquire);
+			if (!items)
+			{
+				items = decode(r);
+			}
+			return items[i % runLength];
+		}
+
+		T_DictItem const* find(std::string_view key)
+		{
+			// binary search for the last run whose first key is not past the key
+			const uint64_t keyHash = hasHashedKeys ? hashKey(key) : 0u;
+			const size_t first = hasHashedKeys
+				? runAfter(keyHash, [this](size_t r) { return firstKeyHashOf(r); })
+				: runAfter(key, [this](size_t r) { return firstKeyOf(r); });
+			if (first == 0)
+			{
+				return nullptr;
+			}
+
+			// then scan the run, its keys are sorted as well
+			const size_t r = first - 1;
+			auto range = rangeOf(r);
+			RecordKey recordKey;
+			size_t matched = 0;
+			uint64_t previousEnd = 0;
+			T_DictItem scratch;
+			for (size_t j = 0; j < runSize(r); ++j)
+			{
+				readRecord(range.first, range.second, recordKey, previousEnd, scratch);
+				int order = 0;
+				if (hasHashedKeys)
+				{
+					order = (recordKey.hash < keyHash) ? -1 : (recordKey.hash > keyHash ? 1 : 0);
+				}
+				else
+				{
+					matched = matchedLength(recordKey, matched, key);
+					order = compareKeys(recordKey, matched, key);
+				}
+				if (order == 0)
+				{
+					return &at(r * runLength + j);
+				}
+				if (order > 0)
+				{
+					break;
+				}
+			}
+			return nullptr;
+		}
+	};
+	struct T_DictCategory
+	{
+		uint64_t blockOffset = 0;
+		uint32_t blockSize = 0;
+		uint32_t blockRawSize = 0;
+		uint32_t blockChecksum = 0;
+		uint64_t presetOffset = 0;
+		uint32_t presetSize = 0; // zero if the category has no preset dictionary
+		uint32_t presetRawSize = 0;
+		uint32_t n_items = 0;
+		T_Bytes preset; // loaded when the category block is decoded
+		ItemTable items;
+		std::atomic<bool> isDecoded { false };
+	};
+	using T_DictMap = FlatIndex<T_DictCategory>;
+
+	// the dictionary is never modified once it was read (until dropDict is called)
+	// so lookups from multiple threads need no locking; category items are filled in
+	// once when the category block is decoded and never modified afterwards
+	T_DictMap dictMap;
+	std::atomic<bool> dictWasRead { false };
+
+	uint64_t totalDatafileSize = 0;
+
+	DatafileChecksumFunc chksumFunc = DatafileChecksumFunc::ADLER32;
+
+	bool hasHashedKeys = false; // category blocks hold key hashes instead of keys
+	uint64_t dictId = 0; // fingerprint written by lime, see ResourceId
+
+	uint32_t dictSize = 0;
+	uint32_t dictRawSize = 0;
+	uint32_t dictChecksum = 0;
+	uint64_t dictOffset = 0;
+
+	bool wasValidated = false;
+
+	// compressed data of resident categories, kept in memory while the dictionary is loaded
+	struct T_ResidentBlock
+	{
+		uint64_t offset = 0;
+		T_Bytes data;
+	};
+	std::vector<T_ResidentBlock> residentBlocks; // sorted by offset
+
+	// datafile handle, positional reads don't share a seek pointer so concurrent
+	// extraction is possible
+#if defined(_WIN32)
+	HANDLE datafileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+#else
+	int datafileDescriptor = -1;
+#endif
+	uint64_t datafileSize = 0;
+
+	// memory mapping (used when options.memoryMap is set)
+	Bytef const* mappedData = nullptr;
+
+	std::atomic<size_t> n_extractors { 0 };
+
+	// guards opening and closing of the datafile
+	std::mutex datafileMutex;
+
+	// guards datafile validation and dictionary construction
+	std::mutex dictMutex;
+
+	// guards decoding of category blocks
+	std::mutex categoryMutex;
+
+	bool datafileIsOpen() const
+	{
+#if defined(_WIN32)
+		return datafileHandle != INVALID_HANDLE_VALUE;
+#else
+		return datafileDescriptor != -1;
+#endif
+	}
+
+	void mapDatafile()
+	{
+		if (datafileSize == 0)
+		{
+			throw Exception::UnknownFormat();
+		}
+#if defined(_WIN32)
+		mappingHandle = CreateFileMappingA(datafileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mappingHandle == NULL)
+		{
+			throw Exception::UnableToOpen(datafileFilename);
+		}
+		const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL)
+		{
+			CloseHandle(mappingHandle);
+			mappingHandle = NULL;
+			throw Exception::UnableToOpen(datafileFilename);
+		}
+#else
+		void* view = ::mmap(nullptr, static_cast<size_t>(datafileSize), PROT_READ, MAP_PRIVATE, datafileDescriptor, 0);
+		if (view == MAP_FAILED)
+		{
+			throw Exception::UnableToOpen(datafileFilename);
+		}
+#endif
+		mappedData = static_cast<Bytef const*>(view);
+	}
+
+	void unmapDatafile()
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(mappedData);
+		CloseHandle(mappingHandle);
+		mappingHandle = NULL;
+#else
+		::munmap(const_cast<Bytef*>(mappedData), static_cast<size_t>(datafileSize));
+#endif
+		mappedData = nullptr;
+	}
+
+	void openDatafile()
+	{
+		if (datafileIsOpen())
+		{
+			return;
+		}
+#if defined(_WIN32)
+		datafileHandle = CreateFileA(datafileFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		LARGE_INTEGER fileSize;
+		if (datafileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(datafileHandle, &fileSize))
+		{
+			closeDatafile();
+			throw Exception::UnableToOpen(datafileFilename);
+		}
+		datafileSize = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+		datafileDescriptor = ::open(datafileFilename.c_str(), O_RDONLY);
+		struct stat fileStat;
+		if (datafileDescriptor == -1 || ::fstat(datafileDescriptor, &fileStat) != 0)
+		{
+			closeDatafile();
+			throw Exception::UnableToOpen(datafileFilename);
+		}
+		datafileSize = static_cast<uint64_t>(fileStat.st_size);
+#endif
+		if (options.memoryMap)
+		{
+			try {
+				mapDatafile();
+			}
+			catch (...) {
+				closeDatafile();
+				throw;
+			}
+		}
+	}
+
+	void closeDatafile()
+	{
+		if (mappedData)
+		{
+			unmapDatafile();
+		}
+#if defined(_WIN32)
+		if (datafileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(datafileHandle);
+			datafileHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (datafileDescriptor != -1)
+		{
+			::close(datafileDescriptor);
+			datafileDescriptor = -1;
+		}
+#endif
+		datafileSize = 0;
+	}
+
+	void readBytesAt(Bytef* destination, uint64_t offset, size_t size) const
+	{
+		if (offset > datafileSize || size > datafileSize - offset)
+		{
+			throw Exception::CorruptedFile();
+		}
+		if (mappedData)
+		{
+			std::copy(mappedData + offset, mappedData + offset + size, destination);
+			return;
+		}
+		while (size > 0)
+		{
+#if defined(_WIN32)
+			OVERLAPPED overlapped = {};
+			overlapped.Offset = static_cast<DWORD>(offset);
+			overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			DWORD bytesRead = 0;
+			const DWORD bytesToRead = static_cast<DWORD>(std::min(size, static_cast<size_t>(0x40000000u)));
+			if (!ReadFile(datafileHandle, destination, bytesToRead, &bytesRead, &overlapped) || bytesRead == 0)
+			{
+				throw Exception::CorruptedFile();
+			}
+#else
+			const ssize_t bytesRead = ::pread(datafileDescriptor, destination, size, static_cast<off_t>(offset));
+			if (bytesRead == -1 && errno == EINTR)
+			{
+				continue;
+			}
+			if (bytesRead <= 0)
+			{
+				throw Exception::CorruptedFile();
+			}
+#endif
+			destination += bytesRead;
+			offset += bytesRead;
+			size -= bytesRead;
+		}
+	}
+
+	template<class T>
+	void readValueAt(T& value, uint64_t& at) const
+	{
+		Bytef buffer[sizeof(T)];
+		readBytesAt(buffer, at, sizeof(T));
+		value = 0;
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			value = (value << 8) + buffer[i];
+		}
+		at += sizeof(T);
+	}
+
+	template<class T>
+	void readValueFromBytes(T& value, T_Bytes const& bytes, size_t& at) const
+	{
+		value = 0;
+		size_t n_bytes = sizeof(T);
+		for (size_t i = 0; i < n_bytes; ++i)
+		{
+			value = (value << 8) + bytes[at + i];
+		}
+		at += n_bytes;
+	}
+
+	template<class T>
+	void readBytesAt(T& destination, uint64_t& at, size_t size) const
+	{
+		destination.resize(size);
+		if (size > 0)
+		{
+			readBytesAt(reinterpret_cast<Bytef*>(&destination[0]), at, size);
+		}
+		at += size;
+	}
+
+	std::string_view viewStringInBytes(size_t size, T_Bytes const& buffer, size_t& at) const
+	{
+		std::string_view view(reinterpret_cast<const char*>(buffer.data() + at), size);
+		at += size;
+		return view;
+	}
+
+	// inflate state and input buffer reused by all extractions on the same thread
+	// the stream is reset between extractions instead of being set up and torn down each time
+	struct InflateContext
+	{
+		z_stream stream;
+		bool isInitialized = false;
+		T_Bytes inputBuffer;
+
+		~InflateContext()
+		{
+			if (isInitialized)
+			{
+				inflateEnd(&stream);
+			}
+		}
+
+		z_stream& acquire()
+		{
+			if (isInitialized)
+			{
+				if (inflateReset(&stream) != Z_OK)
+				{
+					throw Exception::Decompress();
+				}
+				return stream;
+			}
+			stream.zalloc = Z_NULL;
+			stream.zfree = Z_NULL;
+			stream.opaque = Z_NULL;
+			stream.avail_in = 0u;
+			stream.next_in = Z_NULL;
+			if (inflateInit(&stream) != Z_OK)
+			{
+				throw Exception::Decompress();
+			}
+			isInitialized = true;
+			return stream;
+		}
+	};
+
+	// Lime computes adler32 with a starting value of 0 instead of the standard 1, which only
+	// offsets both adler sums; converts a standard adler32 of length bytes into Lime's form
+	static uint32_t limeAdler32(uLong adler, uint64_t length)
+	{
+		static const uint32_t adlerBase = 65521u;
+		const uint32_t a = static_cast<uint32_t>(adler & 0xffffu);
+		const uint32_t b = static_cast<uint32_t>((adler >> 16) & 0xffffu);
+		const uint32_t limeA = (a + adlerBase - 1u) % adlerBase;
+		const uint32_t limeB = (b + adlerBase - static_cast<uint32_t>(length % adlerBase)) % adlerBase;
+		return (limeB << 16) | limeA;
+	}
+
+	static InflateContext& inflateContext()
+	{
+		thread_local InflateContext context;
+		return context;
+	}
+
+	// inflates a single zlib stream of size bytes at offset into output, which receives exactly
+	// rawSize bytes; source may point at compressed data that is already in memory, otherwise
+	// data is read from the datafile
+	// streams deflated with a preset dictionary (Codec::PRESET) are inflated with preset
+	// returns the checksum of the output if verify is set (standard adler32 or crc32)
+	uLong inflateStream(Bytef* output, size_t rawSize, uint64_t offset, size_t size, bool verify, Bytef const* source, T_Bytes const* preset = nullptr) const
+	{
+		if (size == 0)
+		{
+			throw Exception::Decompress();
+		}
+
+		const size_t inBuffSize = std::max(options.readBufferSize, static_cast<size_t>(1u));
+
+		if (!source && !residentBlocks.empty())
+		{
+			source = findResidentData(offset, size);
+		}
+		if (!source)
+		{
+			if (offset > datafileSize || size > datafileSize - offset)
+			{
+				throw Exception::CorruptedFile();
+			}
+			if (mappedData)
+			{
+				source = mappedData + offset;
+			}
+		}
+
+		InflateContext& context = inflateContext();
+		z_stream& dcmpStream = context.acquire();
+		T_Bytes& inputBuffer = context.inputBuffer;
+		size_t remainingBytesToRead = size;
+		size_t remainingBytesToWrite = rawSize;
+
+		Bytef emptyOutput = 0;
+		dcmpStream.next_out = (rawSize > 0) ? output : &emptyOutput;
+		dcmpStream.avail_out = 0u;
+
+		// zlib verifies the adler32 trailer of every stream, which is the same checksum Lime
+		// stores for adler32 datafiles; crc32 is computed over each output chunk while it is
+		// still in cache instead of in a second pass over the whole buffer
+		const bool crc32Check = (verify && chksumFunc == DatafileChecksumFunc::CRC32);
+		static const size_t crc32ChunkSize = 32u * 1024u;
+		const size_t outputChunkSize = (crc32Check) ? crc32ChunkSize : static_cast<size_t>(UINT_MAX);
+		uLong checksum = 0ul;
+
+		int streamState = Z_OK;
+
+		do {
+			if (dcmpStream.avail_in == 0 && remainingBytesToRead != 0)
+			{
+				size_t bytesToRead = 0;
+				if (source)
+				{
+					// inflate straight from memory (or the mapping), no intermediate copy
+					bytesToRead = std::min(static_cast<size_t>(UINT_MAX), remainingBytesToRead);
+					dcmpStream.next_in = const_cast<Bytef*>(source);
+					source += bytesToRead;
+				}
+				else
+				{
+					bytesToRead = std::min(inBuffSize, remainingBytesToRead);
+					readBytesAt(inputBuffer, offset, bytesToRead);
+					dcmpStream.next_in = &inputBuffer[0];
+				}
+				remainingBytesToRead -= bytesToRead;
+				dcmpStream.avail_in = static_cast<unsigned int>(bytesToRead);
+			}
+
+			if (dcmpStream.avail_out == 0 && remainingBytesToWrite != 0)
+			{
+				const size_t bytesToWrite = std::min(outputChunkSize, remainingBytesToWrite);
+				remainingBytesToWrite -= bytesToWrite;
+				dcmpStream.avail_out = static_cast<unsigned int>(bytesToWrite);
+			}
+
+			Bytef* const chunkBegin = dcmpStream.next_out;
+
+			streamState = inflate(&dcmpStream, Z_NO_FLUSH);
+
+			if (streamState == Z_NEED_DICT && preset)
+			{
+				// zlib tests the dictionary against the id stored in the stream
+				streamState = (inflateSetDictionary(&dcmpStream, preset->data(), static_cast<uInt>(preset->size())) == Z_OK) ? Z_OK : Z_DATA_ERROR;
+			}
+
+			if (streamState != Z_OK && streamState != Z_STREAM_END)
+			{
+				throw Exception::Decompress();
+			}
+
+			if (crc32Check)
+			{
+				checksum = crc32_z(checksum, chunkBegin, static_cast<size_t>(dcmpStream.next_out - chunkBegin));
+			}
+
+		} while (streamState != Z_STREAM_END);
+
+		if (dcmpStream.total_out != rawSize)
+		{
+			throw Exception::CorruptedFile();
+		}
+
+		// after the stream end dcmpStream.adler holds the (already verified) adler32 of the output
+		if (verify && chksumFunc == DatafileChecksumFunc::ADLER32)
+		{
+			checksum = dcmpStream.adler;
+		}
+		return checksum;
+	}
+
+	// decodes data packed with the built-in LZ codec (see format.txt) into exactly rawSize bytes
+	static void decodeLz(Bytef const* input, size_t size, Bytef* output, size_t rawSize)
+	{
+		static const size_t minMatchLength = 4u;
+		Bytef const* const inputEnd = input + size;
+		Bytef* const outputBegin = output;
+		Bytef* const outputEnd = output + rawSize;
+
+		// lengths of 15 continue in the following bytes, up to and including the first byte below 255
+		auto readLength = [&input, inputEnd](size_t length) {
+			if (length == 15u)
+			{
+				Bytef lengthByte = 0;
+				do {
+					if (input == inputEnd)
+					{
+						throw Exception::Decompress();
+					}
+					lengthByte = *input++;
+					length += lengthByte;
+				} while (lengthByte == 255u);
+			}
+			return length;
+		};
+
+		for (;;)
+		{
+			if (input == inputEnd)
+			{
+				throw Exception::Decompress();
+			}
+			const Bytef token = *input++;
+
+			const size_t literalCount = readLength(token >> 4);
+			if (literalCount > static_cast<size_t>(inputEnd - input) || literalCount > static_cast<size_t>(outputEnd - output))
+			{
+				throw Exception::Decompress();
+			}
+			std::copy(input, input + literalCount, output);
+			input += literalCount;
+			output += literalCount;
+
+			// the last sequence holds literals only
+			if (input == inputEnd)
+			{
+				break;
+			}
+
+			if (inputEnd - input < 2)
+			{
+				throw Exception::Decompress();
+			}
+			const size_t matchOffset = static_cast<size_t>(input[0]) | (static_cast<size_t>(input[1]) << 8);
+			input += 2;
+			const size_t matchLength = readLength(token & 15u) + minMatchLength;
+			if (matchOffset == 0 || matchOffset > static_cast<size_t>(output - outputBegin) || matchLength > static_cast<size_t>(outputEnd - output))
+			{
+				throw Exception::Decompress();
+			}
+			Bytef const* match = output - matchOffset;
+			if (matchOffset >= matchLength)
+			{
+				std::copy(match, match + matchLength, output);
+			}
+			else
+			{
+				// overlapping match repeats the last matchOffset bytes
+				for (size_t i = 0; i < matchLength; ++i)
+				{
+					output[i] = match[i];
+				}
+			}
+			output += matchLength;
+		}
+
+		if (output != outputEnd)
+		{
+			throw Exception::CorruptedFile();
+		}
+	}
+
+	// standard checksum (as returned by inflateStream) of data that didn't go through zlib
+	uLong checksumOf(Bytef const* data, size_t size) const
+	{
+		switch (chksumFunc)
+		{
+			case DatafileChecksumFunc::ADLER32:
+				return adler32_z(adler32(0ul, Z_NULL, 0), data, size);
+			case DatafileChecksumFunc::CRC32:
+				return crc32_z(0ul, data, size);
+			default:
+				return 0ul;
+		}
+	}
+
+	// LZ counterpart of inflateStream, the compressed data is decoded in one go
+	uLong decodeLzStream(Bytef* output, size_t rawSize, uint64_t offset, size_t size, bool verify, Bytef const* source) const
+	{
+		if (!source && !residentBlocks.empty())
+		{
+			source = findResidentData(offset, size);
+		}
+		if (!source)
+		{
+			if (offset > datafileSize || size > datafileSize - offset)
+			{
+				throw Exception::CorruptedFile();
+			}
+			if (mappedData)
+			{
+				source = mappedData + offset;
+			}
+		}
+
+		T_Bytes localBuffer;
+		if (!source)
+		{
+			// small streams are read into the reusable per-thread buffer
+			T_Bytes& inputBuffer = (size <= options.readBufferSize) ? inflateContext().inputBuffer : localBuffer;
+			readBytesAt(inputBuffer, offset, size);
+			source = inputBuffer.data();
+		}
+
+		Bytef emptyOutput = 0;
+		decodeLz(source, size, (rawSize > 0) ? output : &emptyOutput, rawSize);
+		return (verify) ? checksumOf(output, rawSize) : 0ul;
+	}
+
+	uLong decodeStream(Codec codec, Bytef* output, size_t rawSize, uint64_t offset, size_t size, bool verify, Bytef const* source, T_Bytes const* preset = nullptr) const
+	{
+		if (codec == Codec::LZ)
+		{
+			return decodeLzStream(output, rawSize, offset, size, verify, source);
+		}
+		return inflateStream(output, rawSize, offset, size, verify, source, (codec == Codec::PRESET) ? preset : nullptr);
+	}
+
+	// appends the checksum of the next length bytes to a running checksum (as returned by inflateStream)
+	uLong combineChecksums(uLong checksum, uLong nextChecksum, size_t length) const
+	{
+		switch (chksumFunc)
+		{
+			case DatafileChecksumFunc::ADLER32:
+				return adler32_combine(checksum, nextChecksum, static_cast<z_off_t>(length));
+			case DatafileChecksumFunc::CRC32:
+				return crc32_combine(checksum, nextChecksum, static_cast<z_off_t>(length));
+			default:
+				return 0ul;
+		}
+	}
+
+	// tests a checksum returned by inflateStream against the checksum stored in the datafile
+	void verifyChecksum(uLong checksum, size_t rawSize, uint32_t knownChecksum) const
+	{
+		// (empty data has nothing to verify)
+		if (rawSize == 0 || chksumFunc == DatafileChecksumFunc::NONE)
+		{
+			return;
+		}
+		if (chksumFunc == DatafileChecksumFunc::ADLER32)
+		{
+			checksum = limeAdler32(checksum, rawSize);
+		}
+		if (static_cast<uint32_t>(checksum) != knownChecksum)
+		{
+			throw Exception::CorruptedFile();
+		}
+	}
+
+	void readCompressedStream(T_Bytes& destination, uint64_t offset, size_t size, size_t rawSize, uint32_t knownChecksum, bool verify, Bytef const* source = nullptr, Codec codec = Codec::DEFLATE, T_Bytes const* preset = nullptr) const
+	{
+		// the uncompressed size is known up front so we inflate straight into an exactly-sized buffer
+		destination.resize(rawSize);
+		const uLong checksum = decodeStream(codec, destination.data(), rawSize, offset, size, verify, source, preset);
+		if (verify)
+		{
+			verifyChecksum(checksum, rawSize, knownChecksum);
+		}
+	}
+
+	// copies data from a resident block if it is there, otherwise reads it from the datafile
+	void readItemBytes(Bytef* destination, uint64_t offset, size_t size) const
+	{
+		Bytef const* residentData = findResidentData(offset, size);
+		if (residentData)
+		{
+			std::copy(residentData, residentData + size, destination);
+			return;
+		}
+		readBytesAt(destination, offset, size);
+	}
+
+	// items packed in blocks (lime -blocksize) start with a table of 64-bit block end offsets,
+	// relative to the first block, followed by the independently compressed blocks
+	static size_t blockCountOf(T_DictItem const& dictItem)
+	{
+		return static_cast<size_t>((dictItem.rawSize + dictItem.blockSize - 1u) / dictItem.blockSize);
+	}
+
+	// fills blockBounds with datafile offsets so that block i (first <= i <= last) spans
+	// [blockBounds[i - first], blockBounds[i - first + 1])
+	void readBlockBounds(std::vector<uint64_t>& blockBounds, T_DictItem const& dictItem, size_t first, size_t last) const
+	{
+		const uint64_t tableSize = static_cast<uint64_t>(blockCountOf(dictItem)) * 8u;
+		if (tableSize > dictItem.size)
+		{
+			throw Exception::CorruptedFile();
+		}
+		const uint64_t blocksBegin = dictItem.seek_id + tableSize;
+		const uint64_t itemEnd = dictItem.seek_id + dictItem.size;
+
+		// the start of a block is the end of the one before it
+		const size_t firstEntry = (first > 0) ? first - 1 : 0;
+		T_Bytes tableBytes((last - firstEntry + 1) * 8u);
+		readItemBytes(tableBytes.data(), dictItem.seek_id + firstEntry * 8u, tableBytes.size());
+
+		blockBounds.clear();
+		if (first == 0)
+		{
+			blockBounds.push_back(blocksBegin);
+		}
+		size_t readAt = 0;
+		while (readAt < tableBytes.size())
+		{
+			uint64_t blockEnd = 0;
+			readValueFromBytes(blockEnd, tableBytes, readAt);
+			blockEnd += blocksBegin;
+			if (blockEnd > itemEnd || (!blockBounds.empty() && blockEnd < blockBounds.back()))
+			{
+				throw Exception::CorruptedFile();
+			}
+			blockBounds.push_back(blockEnd);
+		}
+	}
+
+	// blocks of an item being inflated, shared between the extracting thread and pool workers
+	// which help with large items; workers that start after all blocks were taken only touch
+	// this state, so it is kept alive by the workers themselves
+	struct T_BlockInflate
+	{
+		Codec codec = Codec::DEFLATE;
+		Bytef* output = nullptr;
+		size_t rawSize = 0;
+		size_t blockSize = 0;
+		size_t n_blocks = 0;
+		bool verify = false;
+		std::vector<uint64_t> blockBounds;
+		std::vector<uLong> blockChecksums;
+
+		std::atomic<size_t> nextBlock { 0 };
+		std::atomic<size_t> n_blocksDone { 0 };
+		std::mutex mutex;
+		std::condition_variable doneCondition;
+		std::exception_ptr exception;
+	};
+
+	void inflateBlocksOf(T_BlockInflate& state) const
+	{
+		for (;;)
+		{
+			const size_t i = state.nextBlock.fetch_add(1);
+			if (i >= state.n_blocks)
+			{
+				return;
+			}
+			try {
+				const size_t blockBegin = i * state.blockSize;
+				const size_t blockRawSize = std::min(state.blockSize, state.rawSize - blockBegin);
+				state.blockChecksums[i] = decodeStream(state.codec, state.output + blockBegin, blockRawSize, state.blockBounds[i], static_cast<size_t>(state.blockBounds[i + 1] - state.blockBounds[i]), state.verify, nullptr);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(state.mutex);
+				if (!state.exception)
+				{
+					state.exception = std::current_exception();
+				}
+			}
+			if (state.n_blocksDone.fetch_add(1) + 1 == state.n_blocks)
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.doneCondition.notify_all();
+			}
+		}
+	}
+
+	void inflateBlocks(T_Bytes& destination, T_DictItem const& dictItem, bool verify) const
+	{
+		// items at least this large are inflated on several threads
+		static const uint64_t minParallelInflateSize = 4u * 1024u * 1024u;
+
+		const size_t rawSize = static_cast<size_t>(dictItem.rawSize);
+		destination.resize(rawSize);
+		if (rawSize == 0)
+		{
+			return;
+		}
+
+		auto state = std::make_shared<T_BlockInflate>();
+		state->codec = dictItem.codec;
+		state->output = destination.data();
+		state->rawSize = rawSize;
+		state->blockSize = dictItem.blockSize;
+		state->n_blocks = blockCountOf(dictItem);
+		state->verify = verify;
+		state->blockChecksums.resize(state->n_blocks);
+		readBlockBounds(state->blockBounds, dictItem, 0, state->n_blocks - 1);
+
+		// blocks are independent zlib streams, so pool workers inflate them straight into their
+		// place in the output buffer while this thread works through the blocks as well
+		if (options.parallelInflate && state->n_blocks > 1 && dictItem.rawSize >= minParallelInflateSize)
+		{
+			std::lock_guard<std::mutex> lock(asyncMutex);
+			WorkerPool& pool = acquireWorkerPool();
+			const size_t n_helpers = std::min(pool.size(), state->n_blocks - 1);
+			for (size_t i = 0; i < n_helpers; ++i)
+			{
+				pool.submit([this, state]() { inflateBlocksOf(*state); });
+			}
+		}
+		inflateBlocksOf(*state);
+		{
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->doneCondition.wait(lock, [&state]() { return state->n_blocksDone == state->n_blocks; });
+			if (state->exception)
+			{
+				std::rethrow_exception(state->exception);
+			}
+		}
+
+		if (verify)
+		{
+			uLong checksum = (chksumFunc == DatafileChecksumFunc::ADLER32) ? adler32(0ul, Z_NULL, 0) : 0ul;
+			for (size_t i = 0; i < state->n_blocks; ++i)
+			{
+				const size_t blockRawSize = std::min(state->blockSize, rawSize - i * state->blockSize);
+				checksum = combineChecksums(checksum, state->blockChecksums[i], blockRawSize);
+			}
+			verifyChecksum(checksum, rawSize, dictItem.checksum);
+		}
+	}
+
+	void validateAndExtractHeader()
+	{
+		if (!datafileIsOpen())
+		{
+			throw Exception::Unknown();
+		}
+
+		// filesize sanity check
+		totalDatafileSize = datafileSize;
+		if (totalDatafileSize < minimumDatafileSize)
+		{
+			throw Exception::UnknownFormat();
+		}
+
+		// retreive bgn and end endpoints
+		uint64_t readAt = 0;
+		std::string bgnEndpointStr;
+		readBytesAt(bgnEndpointStr, readAt, LM_ENDPOINT_LENGTH);
+
+		uint64_t endEndpointAt = totalDatafileSize - LM_ENDPOINT_LENGTH;
+		std::string endEndpointStr;
+		readBytesAt(endEndpointStr, endEndpointAt, LM_ENDPOINT_LENGTH);
+
+		// validate endpoints and extract checksum function used
+		if (bgnEndpointStr == LM_BGN_ADLER32 && endEndpointStr == LM_END_ADLER32)
+		{
+			chksumFunc = DatafileChecksumFunc::ADLER32;
+		}
+		else if (bgnEndpointStr == LM_BGN_CRC32 && endEndpointStr == LM_END_CRC32)
+		{
+			chksumFunc = DatafileChecksumFunc::CRC32;
+		}
+		else if (bgnEndpointStr == LM_BGN_NOCHKSUM && endEndpointStr == LM_END_NOCHKSUM)
+		{
+			chksumFunc = DatafileChecksumFunc::NONE;
+		}
+		else
+		{
+			throw Exception::UnknownFormat();
+		}
+
+		// retreive revision number
+		uint8_t limeRevision = 0;
+		readValueAt(limeRevision, readAt);
+
+		if (limeRevision != LIME_REVISION)
+		{
+			// for now we assume that any version other than current version is unreadable;
+			// future versions may allow backwards format compatibility
+			throw Exception::VersionMismatch();
+		}
+
+		uint8_t headStrLength = 0;
+		readValueAt(headStrLength, readAt);
+
+		if (options.checkHeadString)
+		{
+			std::string headStr;
+			readBytesAt(headStr, readAt, headStrLength);
+
+			if (headStr != options.headString)
+			{
+				throw Exception::UnknownDatafile();
+			}
+		}
+		else if (headStrLength > 0)
+		{
+			readAt += headStrLength;
+		}
+
+		// extract header data
+		readValueAt(dictSize, readAt);
+		readValueAt(dictRawSize, readAt);
+		if (chksumFunc != DatafileChecksumFunc::NONE)
+		{
+			readValueAt(dictChecksum, readAt);
+		}
+
+		// calculate offsets
+		dictOffset = totalDatafileSize - dictSize - LM_ENDPOINT_LENGTH;
+
+		// validation complete
+		wasValidated = true;
+	}
+
+	void readDict()
+	{
+		if (!datafileIsOpen() || !wasValidated)
+		{
+			throw Exception::Unknown();
+		}
+
+		T_DictMap newDictMap;
+
+		T_Bytes dictBytes;
+		readCompressedStream(dictBytes, dictOffset, dictSize, dictRawSize, dictChecksum, options.integrityCheck);
+
+		size_t readAt = 0;
+
+		uint8_t dictFlags = 0;
+		readValueFromBytes(dictFlags, dictBytes, readAt);
+		if ((dictFlags & ~LIME_DICT_HASHED_KEYS) != 0)
+		{
+			throw Exception::CorruptedFile();
+		}
+		hasHashedKeys = (dictFlags & LIME_DICT_HASHED_KEYS) != 0;
+
+		if (readAt + sizeof(dictId) > dictBytes.size())
+		{
+			throw Exception::CorruptedFile();
+		}
+		readValueFromBytes(dictId, dictBytes, readAt);
+
+		uint32_t n_categories = 0;
+		readVarint(n_categories, dictBytes, readAt, dictBytes.size());
+
+		newDictMap.reset(n_categories, dictBytes.size());
+		for (size_t i = 0; i < n_categories; ++i)
+		{
+			uint8_t categoryKeyLength = 0;
+			readValueFromBytes(categoryKeyLength, dictBytes, readAt);
+
+			std::string_view categoryKey = viewStringInBytes(categoryKeyLength, dictBytes, readAt);
+
+			T_DictCategory* newDictCategory = newDictMap.set(i, categoryKey);
+			if (!newDictCategory)
+			{
+				// category keys are unique
+				throw Exception::CorruptedFile();
+			}
+			T_DictCategory& dictCategory = *newDictCategory;
+			readVarint(dictCategory.n_items, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.blockOffset, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.blockSize, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.blockRawSize, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.presetOffset, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.presetSize, dictBytes, readAt, dictBytes.size());
+			readVarint(dictCategory.presetRawSize, dictBytes, readAt, dictBytes.size());
+			if (chksumFunc != DatafileChecksumFunc::NONE)
+			{
+				readValueFromBytes(dictCategory.blockChecksum, dictBytes, readAt);
+			}
+		}
+
+		// done reading dict
+		dictMap = std::move(newDictMap);
+
+		// category blocks are decoded on first access unless lazy decoding is disabled;
+		// resident categories are always decoded up front
+		if (!options.lazyDict)
+		{
+			for (size_t i = 0; i < dictMap.size(); ++i)
+			{
+				decodeCategory(dictMap.at(i));
+			}
+		}
+		for (auto const& category : options.residentCategories)
+		{
+			T_DictCategory* dictCategory = dictMap.find(category);
+			if (dictCategory)
+			{
+				decodeCategory(*dictCategory);
+			}
+		}
+		loadResidentBlocks();
+		dictWasRead.store(true, std::memory_order_release);
+	}
+
+	void decodeCategory(T_DictCategory& dictCategory)
+	{
+		if (dictCategory.isDecoded.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		T_Bytes blockBytes;
+		readCompressedStream(blockBytes, dictCategory.blockOffset, dictCategory.blockSize, dictCategory.blockRawSize, dictCategory.blockChecksum, options.integrityCheck);
+
+		// the preset dictionary is checked by zlib (stream trailer and dictionary id)
+		if (dictCategory.presetSize != 0)
+		{
+			readCompressedStream(dictCategory.preset, dictCategory.presetOffset, dictCategory.presetSize, dictCategory.presetRawSize, 0u, false);
+		}
+
+		// the block is used as it is, records are decoded when they are first looked up
+		dictCategory.items.reset(std::move(blockBytes), dictCategory.n_items, chksumFunc != DatafileChecksumFunc::NONE, hasHashedKeys, &dictCategory.preset);
+
+		dictCategory.isDecoded.store(true, std::memory_order_release);
+	}
+
+	void prepareCategory(T_DictCategory& dictCategory)
+	{
+		if (dictCategory.isDecoded.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(categoryMutex);
+		decodeCategory(dictCategory);
+	}
+
+	void loadResidentBlocks()
+	{
+		residentBlocks.clear();
+
+		// gather the data ranges of all items in resident categories
+		std::vector<std::pair<uint64_t, uint64_t>> ranges;
+		for (auto const& category : options.residentCategories)
+		{
+			T_DictCategory* dictCategory = dictMap.find(category);
+			if (!dictCategory)
+			{
+				continue;
+			}
+			for (size_t i = 0; i < dictCategory->items.size(); ++i)
+			{
+				T_DictItem const& dictItem = dictCategory->items.at(i);
+				ranges.emplace_back(dictItem.seek_id, dictItem.seek_id + dictItem.size);
+			}
+		}
+		std::sort(ranges.begin(), ranges.end());
+
+		// merge adjacent and shared ranges and read each merged range in one go
+		size_t i = 0;
+		while (i < ranges.size())
+		{
+			uint64_t blockBegin = ranges[i].first;
+			uint64_t blockEnd = ranges[i].second;
+			for (++i; i < ranges.size() && ranges[i].first <= blockEnd; ++i)
+			{
+				blockEnd = std::max(blockEnd, ranges[i].second);
+			}
+			T_ResidentBlock block;
+			block.offset = blockBegin;
+			readBytesAt(block.data, blockBegin, static_cast<size_t>(blockEnd - blockBegin));
+			residentBlocks.push_back(std::move(block));
+		}
+	}
+
+	Bytef const* findResidentData(uint64_t offset, uint64_t size) const
+	{
+		auto it = std::upper_bound(residentBlocks.begin(), residentBlocks.end(), offset, [](uint64_t value, T_ResidentBlock const& block) {
+			return value < block.offset;
+		});
+		if (it == residentBlocks.begin())
+		{
+			return nullptr;
+		}
+		--it;
+		if (offset + size > it->offset + it->data.size())
+		{
+			return nullptr;
+		}
+		return it->data.data() + (offset - it->offset);
+	}
+
+	void prepareDict()
+	{
+		if (dictWasRead.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(dictMutex);
+		if (!wasValidated)
+		{
+			validateAndExtractHeader();
+		}
+		if (!dictWasRead.load(std::memory_order_relaxed))
+		{
+			readDict();
+			if (options.integrityCheck && options.integrityPolicy == IntegrityPolicy::SCRUB)
+			{
+				startScrub();
+			}
+		}
+	}
+
+	mutable ResourceCache resourceCache;
+
+	mutable std::atomic<uint64_t> n_sampledExtractions { 0 };
+
+	// decides whether extracting dictItem tests its checksum according to the integrity policy
+	bool shouldVerify(T_DictItem const& dictItem) const
+	{
+		if (!options.integrityCheck)
+		{
+			return false;
+		}
+		switch (options.integrityPolicy)
+		{
+			case IntegrityPolicy::FIRST_ACCESS:
+				return !dictItem.isVerified.load(std::memory_order_relaxed);
+			case IntegrityPolicy::SAMPLED:
+			{
+				const uint64_t sampleRate = std::max(options.integritySampleRate, static_cast<size_t>(1u));
+				return n_sampledExtractions.fetch_add(1, std::memory_order_relaxed) % sampleRate == 0;
+			}
+			case IntegrityPolicy::SCRUB:
+				return false;
+			default:
+				return true;
+		}
+	}
+
+	// stored items are copied straight into the destination (from memory when source is set)
+	void readStoredItem(T_Bytes& destination, T_DictItem const& dictItem, bool verify, Bytef const* source = nullptr) const
+	{
+		const size_t rawSize = static_cast<size_t>(dictItem.rawSize);
+		destination.resize(rawSize);
+		if (rawSize == 0)
+		{
+			return;
+		}
+		if (source)
+		{
+			std::copy(source, source + rawSize, destination.data());
+		}
+		else
+		{
+			readItemBytes(destination.data(), dictItem.seek_id, rawSize);
+		}
+		if (verify)
+		{
+			verifyChecksum(checksumOf(destination.data(), rawSize), rawSize, dictItem.checksum);
+		}
+	}
+
+	// stored items are used in place when the datafile is memory mapped
+	bool viewItem(DataView& view, T_DictItem const& dictItem) const
+	{
+		if (!mappedData || dictItem.codec != Codec::STORED)
+		{
+			return false;
+		}
+		const size_t rawSize = static_cast<size_t>(dictItem.rawSize);
+		if (dictItem.seek_id > datafileSize || rawSize > datafileSize - dictItem.seek_id)
+		{
+			throw Exception::CorruptedFile();
+		}
+		view.data = mappedData + dictItem.seek_id;
+		view.size = rawSize;
+		const bool verify = shouldVerify(dictItem);
+		if (verify)
+		{
+			verifyChecksum(checksumOf(view.data, rawSize), rawSize, dictItem.checksum);
+			dictItem.isVerified.store(true, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	// the most recently inflated solid group, so extracting the members of a group one after
+	// another inflates the group once (with the cache enabled, groups are also cached like items)
+	mutable std::mutex solidGroupMutex;
+	mutable ResourceCache::T_CachedBytes lastSolidGroup;
+	mutable uint64_t lastSolidGroupOffset = 0;
+
+	// a solid group is stored as its 32-bit raw size followed by a single zlib stream
+	ResourceCache::T_CachedBytes inflateSolidGroup(T_DictItem const& dictItem, Bytef const* source) const
+	{
+		const size_t rawSizeLength = sizeof(uint32_t);
+		if (dictItem.size < rawSizeLength)
+		{
+			throw Exception::CorruptedFile();
+		}
+		T_Bytes rawSizeBytes(rawSizeLength);
+		if (source)
+		{
+			std::copy(source, source + rawSizeLength, rawSizeBytes.data());
+		}
+		else
+		{
+			readItemBytes(rawSizeBytes.data(), dictItem.seek_id, rawSizeLength);
+		}
+		size_t readAt = 0;
+		uint32_t groupRawSize = 0;
+		readValueFromBytes(groupRawSize, rawSizeBytes, readAt);
+
+		// zlib checks the stream itself, members are verified with their own checksums
+		auto group = std::make_shared<T_Bytes>();
+		readCompressedStream(*group, dictItem.seek_id + rawSizeLength, static_cast<size_t>(dictItem.size - rawSizeLength), groupRawSize, 0u, false, (source) ? source + rawSizeLength : nullptr);
+		return group;
+	}
+
+	ResourceCache::T_CachedBytes solidGroupOf(T_DictItem const& dictItem, Bytef const* source = nullptr) const
+	{
+		{
+			std::lock_guard<std::mutex> lock(solidGroupMutex);
+			if (lastSolidGroup && lastSolidGroupOffset == dictItem.seek_id)
+			{
+				return lastSolidGroup;
+			}
+		}
+		ResourceCache::T_CachedBytes group;
+		if (resourceCache.isEnabled())
+		{
+			group = resourceCache.fetchShared(dictItem.seek_id);
+		}
+		if (!group)
+		{
+			group = inflateSolidGroup(dictItem, source);
+			if (resourceCache.isEnabled())
+			{
+				resourceCache.store(dictItem.seek_id, group);
+			}
+		}
+		std::lock_guard<std::mutex> lock(solidGroupMutex);
+		lastSolidGroup = group;
+		lastSolidGroupOffset = dictItem.seek_id;
+		return group;
+	}
+
+	// members of a solid group are copied out of the inflated group
+	void readSolidItem(T_Bytes& destination, T_DictItem const& dictItem, bool verify, Bytef const* source = nullptr) const
+	{
+		ResourceCache::T_CachedBytes group = solidGroupOf(dictItem, source);
+		const size_t memberOffset = static_cast<size_t>(dictItem.solidOffset);
+		if (memberOffset > group->size() || dictItem.rawSize > group->size() - memberOffset)
+		{
+			throw Exception::CorruptedFile();
+		}
+		const size_t rawSize = static_cast<size_t>(dictItem.rawSize);
+		destination.assign(group->begin() + memberOffset, group->begin() + memberOffset + rawSize);
+		if (verify)
+		{
+			verifyChecksum(checksumOf(destination.data(), rawSize), rawSize, dictItem.checksum);
+		}
+	}
+
+	void inflateItemData(T_Bytes& destination, T_DictItem const& dictItem, bool verify, Bytef const* source = nullptr) const
+	{
+		if (dictItem.codec == Codec::SOLID)
+		{
+			readSolidItem(destination, dictItem, verify, source);
+			return;
+		}
+		if (dictItem.codec == Codec::STORED)
+		{
+			readStoredItem(destination, dictItem, verify, source);
+			return;
+		}
+		if (dictItem.blockSize != 0)
+		{
+			inflateBlocks(destination, dictItem, verify);
+			return;
+		}
+		readCompressedStream(destination, dictItem.seek_id, static_cast<size_t>(dictItem.size), static_cast<size_t>(dictItem.rawSize), dictItem.checksum, verify, source, dictItem.codec, dictItem.preset);
+	}
+
+	void inflateItem(T_Bytes& destination, T_DictItem const& dictItem, Bytef const* source = nullptr) const
+	{
+		const bool verify = shouldVerify(dictItem);
+		inflateItemData(destination, dictItem, verify, source);
+		if (verify)
+		{
+			dictItem.isVerified.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	// background integrity scrub (IntegrityPolicy::SCRUB)
+	std::thread scrubThread;
+	std::atomic<bool> scrubStopRequested { false };
+	std::atomic<ScrubState> scrubStatus { ScrubState::IDLE };
+
+	static void lowerThreadPriority()
+	{
+#if defined(_WIN32)
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(SCHED_IDLE)
+		sched_param schedParam {};
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &schedParam);
+#endif
+	}
+
+	void startScrub()
+	{
+		scrubStopRequested = false;
+		scrubStatus = ScrubState::RUNNING;
+		scrubThread = std::thread([this]() { scrub(); });
+	}
+
+	void stopScrub()
+	{
+		if (scrubThread.joinable())
+		{
+			scrubStopRequested = true;
+			scrubThread.join();
+		}
+	}
+
+	void scrub()
+	{
+		lowerThreadPriority();
+		try {
+			// keeps the datafile open while scrubbing
+			Extractor ex(*this);
+
+			std::vector<T_DictItem const*> items;
+			for (size_t i = 0; i < dictMap.size(); ++i)
+			{
+				T_DictCategory& dictCategory = dictMap.at(i);
+				prepareCategory(dictCategory);
+				for (size_t j = 0; j < dictCategory.items.size(); ++j)
+				{
+					items.push_back(&dictCategory.items.at(j));
+				}
+			}
+
+			// verify in datafile order, data shared by several items (the same stored bytes) is
+			// verified once; empty items share their seek_id with the next item and members of a
+			// solid group share the group's bytes but not the offset in the group
+			auto rangeOf = [](T_DictItem const* dictItem) {
+				return std::make_tuple(dictItem->seek_id, dictItem->size, dictItem->blockSize, dictItem->solidOffset);
+			};
+			std::sort(items.begin(), items.end(), [&rangeOf](T_DictItem const* a, T_DictItem const* b) {
+				return rangeOf(a) < rangeOf(b);
+			});
+
+			T_Bytes data;
+			for (size_t i = 0; i < items.size(); ++i)
+			{
+				if (scrubStopRequested.load(std::memory_order_relaxed))
+				{
+					scrubStatus = ScrubState::IDLE;
+					return;
+				}
+				T_DictItem const& dictItem = *items[i];
+				if (i == 0 || dictItem.size == 0 || rangeOf(&dictItem) != rangeOf(items[i - 1]))
+				{
+					inflateItemData(data, dictItem, true);
+					std::this_thread::yield();
+				}
+				dictItem.isVerified.store(true, std::memory_order_relaxed);
+			}
+			scrubStatus = ScrubState::PASSED;
+		}
+		catch (...) {
+			scrubStatus = ScrubState::FAILED;
 		}
-		at += n_bytes;
 	}
 
-	template<class T>
-	void readBytesFromStream(T& destination, size_t size)
+	// empty items store no data and share their seek_id with the next item, so they are
+	// never cached; a seek_id then stands for a single item (or solid group)
+	static bool isCached(T_DictItem const& dictItem)
 	{
-		destination.resize(size);
-		datafileStream.read((char*)&destination[0], size);
+		return dictItem.rawSize != 0;
 	}
 
-	void readStringFromBytes(std::string& destination, size_t size, T_Bytes const& buffer, size_t& at)
+	// solid groups are cached as a whole (see solidGroupOf) rather than per member
+	static bool isCachedAsItem(T_DictItem const& dictItem)
 	{
-		destination.resize(size);
-		T_Bytes::const_iterator begin = buffer.begin() + at;
-		T_Bytes::const_iterator end = buffer.begin() + at + size;
-		destination.assign(begin, end);
-		at += size;
+		return isCached(dictItem) && dictItem.codec != Codec::SOLID;
 	}
 
-	void readCompressedStream(T_Bytes& destination, size_t size, uint32_t knownChecksum = 0)
+	void extractItem(T_Bytes& destination, T_DictItem const& dictItem)
 	{
-		if (size == 0)
+		const bool useCache = resourceCache.isEnabled() && isCachedAsItem(dictItem);
+		if (useCache && resourceCache.fetch(dictItem.seek_id, destination))
 		{
-			throw Exception::Decompress();
+			return;
+		}
+		inflateItem(destination, dictItem);
+		if (useCache)
+		{
+			resourceCache.store(dictItem.seek_id, destination);
 		}
+	}
 
-		static const size_t inBuffSize = 500u;
-		static const size_t outBuffSize = 16348u;
+	void readRawItem(RawData& raw, T_DictItem const& dictItem) const
+	{
+		raw.codec = dictItem.codec;
+		raw.rawSize = dictItem.rawSize;
+		raw.blockSize = dictItem.blockSize;
+		raw.solidOffset = dictItem.solidOffset;
+		raw.checksum = dictItem.checksum;
+		raw.preset = (dictItem.codec == Codec::PRESET) ? dictItem.preset : nullptr;
+		raw.data.resize(static_cast<size_t>(dictItem.size));
+		if (!raw.data.empty())
+		{
+			readItemBytes(raw.data.data(), dictItem.seek_id, raw.data.size());
+		}
+	}
 
-		z_stream dcmpStream;
-		dcmpStream.zalloc = Z_NULL;
-		dcmpStream.zfree = Z_NULL;
-		dcmpStream.opaque = Z_NULL;
-		dcmpStream.avail_in = 0u;
-		dcmpStream.next_in = Z_NULL;
-		if (inflateInit(&dcmpStream) != Z_OK)
+	// reads a range of an item's uncompressed data, clamped to the end of the item
+	void readItemRange(T_Bytes& destination, T_DictItem const& dictItem, uint64_t offset, size_t length)
+	{
+		if (offset >= dictItem.rawSize)
 		{
-			throw Exception::Decompress();
+			destination.clear();
+			return;
 		}
+		length = static_cast<size_t>(std::min(static_cast<uint64_t>(length), dictItem.rawSize - offset));
 
-		T_Bytes inputBuffer;
-		inputBuffer.reserve(inBuffSize);
-		size_t totalBytesRead = 0;
-		size_t remainingBytesToRead = size;
-	
-		Bytef* outputBuffer = new Bytef[outBuffSize];
+		if (dictItem.codec == Codec::STORED)
+		{
+			// stored items are read in place
+			destination.resize(length);
+			if (length > 0)
+			{
+				readItemBytes(destination.data(), dictItem.seek_id + offset, length);
+			}
+			return;
+		}
 
-		do {
-			size_t bytesToRead = std::min(inBuffSize, remainingBytesToRead);
-			readBytesFromStream(inputBuffer, bytesToRead);
-			remainingBytesToRead -= bytesToRead;
-
-			dcmpStream.next_in = &inputBuffer[0];
-			dcmpStream.avail_in = static_cast<unsigned int>(bytesToRead);
-
-			do {
-				dcmpStream.next_out = &outputBuffer[0];
-				dcmpStream.avail_out = outBuffSize;
-				
-				int streamState = inflate(&dcmpStream, Z_NO_FLUSH);
-				
-				if (streamState != Z_OK && streamState != Z_STREAM_END)
-				{
-					delete[] outputBuffer;
-					throw Exception::Decompress();
-				}
+		if (dictItem.blockSize == 0)
+		{
+			// items stored as a single stream (or in a solid group) have to be inflated fully
+			T_Bytes itemData;
+			extractItem(itemData, dictItem);
+			destination.assign(itemData.begin() + static_cast<size_t>(offset), itemData.begin() + static_cast<size_t>(offset + length));
+			return;
+		}
 
-				destination.insert(destination.end(), outputBuffer, outputBuffer + (outBuffSize - dcmpStream.avail_out));
+		destination.resize(length);
+		if (length == 0)
+		{
+			return;
+		}
 
-			} while (dcmpStream.avail_out == 0);
+		// only the blocks covering the range are inflated; blocks that lie completely inside the
+		// range are inflated straight into the destination
+		const size_t rawSize = static_cast<size_t>(dictItem.rawSize);
+		const size_t first = static_cast<size_t>(offset / dictItem.blockSize);
+		const size_t last = static_cast<size_t>((offset + length - 1u) / dictItem.blockSize);
+		std::vector<uint64_t> blockBounds;
+		readBlockBounds(blockBounds, dictItem, first, last);
 
-		} while (remainingBytesToRead != 0);
+		T_Bytes blockData;
+		for (size_t i = first; i <= last; ++i)
+		{
+			const size_t blockBegin = i * dictItem.blockSize;
+			const size_t blockRawSize = std::min(static_cast<size_t>(dictItem.blockSize), rawSize - blockBegin);
+			const uint64_t blockOffset = blockBounds[i - first];
+			const size_t blockSize = static_cast<size_t>(blockBounds[i - first + 1] - blockOffset);
 
-		delete[] outputBuffer;
+			const size_t copyBegin = std::max(static_cast<size_t>(offset), blockBegin);
+			const size_t copyEnd = std::min(static_cast<size_t>(offset) + length, blockBegin + blockRawSize);
+			Bytef* const output = destination.data() + (copyBegin - static_cast<size_t>(offset));
 
-		if (inflateEnd(&dcmpStream) != Z_OK)
-		{
-			throw Exception::Decompress();
-		}
-		
-		if (options.integrityCheck)
-		{
-			uint32_t checksum = 0;
-			switch (chksumFunc)
+			if (copyBegin == blockBegin && copyEnd == blockBegin + blockRawSize)
 			{
-				case DatafileChecksumFunc::ADLER32:
-					checksum = adler32_z(0ul, destination.data(), destination.size());
-					break;
-				case DatafileChecksumFunc::CRC32:
-					checksum = crc32_z(0ul, destination.data(), destination.size());
-					break;
+				decodeStream(dictItem.codec, output, blockRawSize, blockOffset, blockSize, false, nullptr);
 			}
-			if (checksum != knownChecksum)
+			else
 			{
-				throw Exception::CorruptedFile();
+				blockData.resize(blockRawSize);
+				decodeStream(dictItem.codec, blockData.data(), blockRawSize, blockOffset, blockSize, false, nullptr);
+				std::copy(blockData.begin() + (copyBegin - blockBegin), blockData.begin() + (copyEnd - blockBegin), output);
 			}
 		}
 	}
 
-	void validateAndExtractHeader()
+	struct T_BatchItem
 	{
-		if (!datafileStream.is_open())
-		{
-			throw Exception::Unknown();
-		}
-
-		// filesize sanity check
-		datafileStream.seekg(0, datafileStream.end);
-		totalDatafileSize = datafileStream.tellg();
-		if (totalDatafileSize < minimumDatafileSize)
-		{
-			throw Exception::UnknownFormat();
-		}
-
-		// retreive bgn and end endpoints
-		datafileStream.seekg(0, datafileStream.beg);
-		std::string bgnEndpointStr;
-		readBytesFromStream(bgnEndpointStr, LM_ENDPOINT_LENGTH);
+		T_DictItem const* dictItem = nullptr;
+		T_Bytes* destination = nullptr;
+	};
 
-		datafileStream.seekg(-LM_ENDPOINT_LENGTH, datafileStream.end);
-		std::string endEndpointStr;
-		readBytesFromStream(endEndpointStr, LM_ENDPOINT_LENGTH);
+	void readCompressedBatch(std::vector<T_BatchItem>& batch) const
+	{
+		// largest single read when merging neighbouring items
+		const uint64_t maxBatchReadSize = options.batchReadSize;
+		// gaps up to this size are read through rather than skipped
+		static const uint64_t maxBatchGapSize = 16u * 1024u;
 
-		// validate endpoints and extract checksum function used
-		if (bgnEndpointStr == LM_BGN_ADLER32 && endEndpointStr == LM_END_ADLER32)
-		{
-			chksumFunc = DatafileChecksumFunc::ADLER32;
-		}
-		else if (bgnEndpointStr == LM_BGN_CRC32 && endEndpointStr == LM_END_CRC32)
-		{
-			chksumFunc = DatafileChecksumFunc::CRC32;
-		}
-		else if (bgnEndpointStr == LM_BGN_NOCHKSUM && endEndpointStr == LM_END_NOCHKSUM)
-		{
-			chksumFunc = DatafileChecksumFunc::NONE;
-		}
-		else
-		{
-			throw Exception::UnknownFormat();
-		}
+		// visit items in datafile order so the file is read in a single forward pass
+		std::sort(batch.begin(), batch.end(), [](T_BatchItem const& a, T_BatchItem const& b) {
+			return a.dictItem->seek_id < b.dictItem->seek_id;
+		});
 
-		// retreive revision number
-		datafileStream.seekg(LM_ENDPOINT_LENGTH);
-		uint8_t limeRevision = 0;
-		readValueFromStream(limeRevision);
+		T_Bytes readBuffer;
 
-		if (limeRevision != LIME_REVISION)
+		size_t i = 0;
+		while (i < batch.size())
 		{
-			// for now we assume that any version other than current version is unreadable;
-			// future versions may allow backwards format compatibility
-			throw Exception::VersionMismatch();
-		}
+			T_DictItem const& first = *batch[i].dictItem;
+			if (mappedData || first.size >= maxBatchReadSize || first.blockSize != 0 || findResidentData(first.seek_id, first.size))
+			{
+				inflateItem(*batch[i].destination, first);
+				++i;
+				continue;
+			}
 
-		uint8_t headStrLength = 0;
-		readValueFromStream(headStrLength);
+			// merge adjacent items (and items sharing data) into a single read
+			const uint64_t runBegin = first.seek_id;
+			uint64_t runEnd = first.seek_id + first.size;
+			size_t j = i + 1;
+			while (j < batch.size())
+			{
+				T_DictItem const& next = *batch[j].dictItem;
+				if (next.blockSize != 0 || findResidentData(next.seek_id, next.size))
+				{
+					break;
+				}
+				const uint64_t nextEnd = std::max(runEnd, next.seek_id + next.size);
+				if (next.seek_id > runEnd + maxBatchGapSize || nextEnd - runBegin > maxBatchReadSize)
+				{
+					break;
+				}
+				runEnd = nextEnd;
+				++j;
+			}
 
-		if (options.checkHeadString)
-		{
-			std::string headStr;
-			readBytesFromStream(headStr, headStrLength);
+			uint64_t readAt = runBegin;
+			readBytesAt(readBuffer, readAt, static_cast<size_t>(runEnd - runBegin));
 
-			if (headStr != options.headString)
+			for (; i < j; ++i)
 			{
-				throw Exception::UnknownDatafile();
+				T_DictItem const& dictItem = *batch[i].dictItem;
+				Bytef const* source = readBuffer.data() + (dictItem.seek_id - runBegin);
+				inflateItem(*batch[i].destination, dictItem, source);
 			}
 		}
-		else if (headStrLength > 0)
+	}
+
+	// asynchronous extraction state; the datafile is kept open while requests are pending
+	// (the pool is also used by const extraction paths for parallel inflate, hence mutable)
+	mutable std::unique_ptr<WorkerPool> workerPool;
+	std::unique_ptr<Extractor> asyncExtractor;
+	size_t n_asyncPending = 0;
+	mutable std::mutex asyncMutex;
+	std::condition_variable asyncIdleCondition;
+
+	// creates the thread pool on first use, must be called with asyncMutex locked
+	WorkerPool& acquireWorkerPool() const
+	{
+		if (!workerPool)
 		{
-			datafileStream.seekg(headStrLength, datafileStream.cur);
+			workerPool = std::make_unique<WorkerPool>(options.threadCount);
 		}
+		return *workerPool;
+	}
 
-		// extract header data
-		readValueFromStream(dictSize);
-		if (chksumFunc != DatafileChecksumFunc::NONE)
+	void finishAsyncRequest()
+	{
+		std::lock_guard<std::mutex> lock(asyncMutex);
+		if (--n_asyncPending == 0)
 		{
-			readValueFromStream(dictChecksum);
+			asyncExtractor.reset();
+			asyncIdleCondition.notify_all();
 		}
-
-		// calculate offsets
-		dictOffset = totalDatafileSize - dictSize - LM_ENDPOINT_LENGTH;
-
-		// validation complete
-		wasValidated = true;
 	}
 
-	void readDict()
+	T_DictItem const* findDictItem(std::string_view category, std::string_view key)
 	{
-		if (!datafileStream.is_open() || !wasValidated)
+		prepareDict();
+		T_DictCategory* dictCategory = dictMap.find(category);
+		if (!dictCategory)
 		{
-			throw Exception::Unknown();
+			return nullptr;
 		}
+		prepareCategory(*dictCategory);
+		return dictCategory->items.find(key);
+	}
 
-		dictMap.clear();
-
-		datafileStream.seekg(dictOffset, datafileStream.beg);
-
-		T_Bytes dictBytes;
-		readCompressedStream(dictBytes, dictSize, dictChecksum);
-
-		size_t readAt = 0;
-
-		uint32_t n_categories = 0;
-		readValueFromBytes(n_categories, dictBytes, readAt);
-
-		for (size_t i = 0; i < n_categories; ++i)
+	T_DictItem const* findDictItem(ResourceId const& id)
+	{
+		prepareDict();
+		if (id.dictId != 0 && id.dictId == dictId && id.category < dictMap.size())
 		{
-			uint8_t categoryKeyLength = 0;
-			readValueFromBytes(categoryKeyLength, dictBytes, readAt);
-
-			std::string categoryKey;
-			readStringFromBytes(categoryKey, categoryKeyLength, dictBytes, readAt);
-
-			uint32_t n_dataNodes;
-			readValueFromBytes(n_dataNodes, dictBytes, readAt);
-
-			for (size_t j = 0; j < n_dataNodes; ++j)
+			T_DictCategory& dictCategory = dictMap.at(id.category);
+			prepareCategory(dictCategory);
+			if (id.item < dictCategory.items.size())
 			{
-				uint8_t dataKeyLength = 0;
-				readValueFromBytes(dataKeyLength, dictBytes, readAt);
-
-				std::string dataKey;
-				readStringFromBytes(dataKey, dataKeyLength, dictBytes, readAt);
-
-				T_DictItem dictItem;
-				readValueFromBytes(dictItem.seek_id, dictBytes, readAt);
-				readValueFromBytes(dictItem.size, dictBytes, readAt);
-				if (chksumFunc != DatafileChecksumFunc::NONE)
-				{
-					readValueFromBytes(dictItem.checksum, dictBytes, readAt);
-				}
-
-				dictMap[categoryKey][dataKey] = dictItem;
+				return &dictCategory.items.at(id.item);
 			}
 		}
-
-		// done reading dict
-		dictWasRead = true;
+		// the id was generated for a different datafile, fall back to a lookup by name
+		return findDictItem(id.categoryName, id.keyName);
 	}
 
 	Unlime(Unlime const&) = delete;
@@ -459,6 +2631,22 @@ private:
 	const Unlime& operator=(Unlime&& other) = delete;
 
 public:
+	// dictionary entry resolved once with Extractor::find
+	// remains valid until dropDict() is called
+	class Handle
+	{
+	private:
+		friend class Extractor;
+
+		T_DictItem const* dictItem = nullptr;
+
+	public:
+		explicit operator bool() const
+		{
+			return dictItem != nullptr;
+		}
+	};
+
 	class Extractor
 	{
 	private:
@@ -473,44 +2661,217 @@ public:
 		Extractor(Unlime& context)
 		: unlime(&context)
 		{
-			if (unlime->n_extractors++ == 0)
+			std::lock_guard<std::mutex> lock(unlime->datafileMutex);
+			if (unlime->n_extractors == 0)
 			{
 				unlime->openDatafile();
 			}
+			++unlime->n_extractors;
 		}
 
 		~Extractor()
 		{
+			std::lock_guard<std::mutex> lock(unlime->datafileMutex);
 			if (--unlime->n_extractors == 0)
 			{
 				unlime->closeDatafile();
 			}
 		}
 
-		bool get(T_Bytes& data, std::string const& category, std::string const& key) const
+		// get() may be called from several threads at once, either on the same Extractor
+		// or on separate Extractors sharing the same Unlime object
+		// category and key are looked up as views, so lookups never allocate
+		bool get(T_Bytes& data, std::string_view category, std::string_view key) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
+			{
+				return false;
+			}
+			unlime->extractItem(data, *dictItem);
+			return true;
+		}
+
+		// same as above but indexes the dictionary directly with an id written by lime -header
+		bool get(T_Bytes& data, ResourceId const& id) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(id);
+			if (!dictItem)
+			{
+				return false;
+			}
+			unlime->extractItem(data, *dictItem);
+			return true;
+		}
+
+		// resolves a resource once so it can be extracted repeatedly without looking it up again
+		// the returned handle evaluates to false if the item was not found
+		Handle find(std::string_view category, std::string_view key) const
+		{
+			Handle handle;
+			handle.dictItem = unlime->findDictItem(category, key);
+			return handle;
+		}
+
+		bool get(T_Bytes& data, Handle const& handle) const
+		{
+			if (!handle)
+			{
+				return false;
+			}
+			unlime->extractItem(data, *handle.dictItem);
+			return true;
+		}
+
+		// views the data of a stored item (Codec::STORED) in place, without copying it; only
+		// possible when the datafile is memory mapped (Options::memoryMap), returns false for
+		// other items, which have to be extracted; the view stays valid while an extractor of
+		// the same Unlime exists (the mapping is released with the last one)
+		bool view(DataView& view, std::string_view category, std::string_view key) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
+			{
+				return false;
+			}
+			return unlime->viewItem(view, *dictItem);
+		}
+
+		bool view(DataView& view, Handle const& handle) const
+		{
+			if (!handle)
+			{
+				return false;
+			}
+			return unlime->viewItem(view, *handle.dictItem);
+		}
+
+		// retreives the compressed data of an item without inflating it (raw.codec tells whether
+		// it is a zlib stream or stored as is, raw.preset holds the dictionary of Codec::PRESET streams
+		// and Codec::SOLID data is the whole group the item is a member of); Adler32 checksums are computed with a starting value of 0 (as done by the packer),
+		// the zlib stream itself carries a standard adler32 trailer
+		bool getRaw(RawData& raw, std::string_view category, std::string_view key) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
+			{
+				return false;
+			}
+			unlime->readRawItem(raw, *dictItem);
+			return true;
+		}
+
+		bool getRaw(RawData& raw, Handle const& handle) const
+		{
+			if (!handle)
+			{
+				return false;
+			}
+			unlime->readRawItem(raw, *handle.dictItem);
+			return true;
+		}
+
+		// reads length bytes of an item's data starting at offset (clamped to the end of the item)
+		// for items packed in blocks (lime -blocksize) only the blocks covering the range are
+		// inflated, other items are extracted in full; since the item checksum covers the whole
+		// item, range reads rely on zlib's own check of each block
+		bool read(T_Bytes& data, Handle const& handle, uint64_t offset, size_t length) const
+		{
+			if (!handle)
+			{
+				return false;
+			}
+			unlime->readItemRange(data, *handle.dictItem, offset, length);
+			return true;
+		}
+
+		// extracts several items at once; items are read in datafile order and neighbouring
+		// items are merged into larger reads, regardless of the order of queries
+		// returns the number of items found (see Query::found for each individual item)
+		size_t getMany(std::vector<Query>& queries) const
+		{
+			size_t n_found = 0;
+			std::vector<T_BatchItem> batch;
+			batch.reserve(queries.size());
+			for (auto& query : queries)
+			{
+				T_DictItem const* dictItem = unlime->findDictItem(query.category, query.key);
+				query.found = (dictItem != nullptr && query.data != nullptr);
+				if (query.found)
+				{
+					++n_found;
+					if (unlime->resourceCache.isEnabled() && isCachedAsItem(*dictItem) && unlime->resourceCache.fetch(dictItem->seek_id, *query.data))
+					{
+						continue;
+					}
+					batch.push_back({ dictItem, query.data });
+				}
+			}
+			unlime->readCompressedBatch(batch);
+			if (unlime->resourceCache.isEnabled())
+			{
+				for (auto const& batchItem : batch)
+				{
+					if (!isCachedAsItem(*batchItem.dictItem))
+					{
+						continue;
+					}
+					unlime->resourceCache.store(batchItem.dictItem->seek_id, *batchItem.destination);
+				}
+			}
+			return n_found;
+		}
+
+		// extracts an item into the cache (if it isn't cached already) and keeps it there
+		// until unpin() is called; pinned items are never evicted
+		// has no effect when the cache is disabled
+		bool pin(std::string_view category, std::string_view key) const
 		{
-			if (!unlime->wasValidated)
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
 			{
-				unlime->validateAndExtractHeader();
+				return false;
 			}
-			if (!unlime->dictWasRead)
+			if (unlime->resourceCache.isEnabled() && isCached(*dictItem) && !unlime->resourceCache.pin(dictItem->seek_id))
 			{
-				unlime->readDict();
+				if (isCachedAsItem(*dictItem))
+				{
+					T_Bytes data;
+					unlime->inflateItem(data, *dictItem);
+					unlime->resourceCache.store(dictItem->seek_id, data, true);
+				}
+				else
+				{
+					// pins the whole solid group
+					unlime->resourceCache.store(dictItem->seek_id, unlime->solidGroupOf(*dictItem), true);
+				}
 			}
-			auto it = unlime->dictMap.find(category);
-			if (it == unlime->dictMap.end())
+			return true;
+		}
+
+		bool unpin(std::string_view category, std::string_view key) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
 			{
 				return false;
 			}
-			auto& collection = it->second;
-			auto it2 = collection.find(key);
-			if (it2 == collection.end())
+			if (isCached(*dictItem))
+			{
+				unlime->resourceCache.unpin(dictItem->seek_id);
+			}
+			return true;
+		}
+
+		// retreives the uncompressed size of an item without extracting it
+		bool sizeOf(uint64_t& size, std::string_view category, std::string_view key) const
+		{
+			T_DictItem const* dictItem = unlime->findDictItem(category, key);
+			if (!dictItem)
 			{
 				return false;
 			}
-			T_DictItem const& dictItem = it2->second;
-			unlime->datafileStream.seekg(dictItem.seek_id);
-			unlime->readCompressedStream(data, static_cast<size_t>(dictItem.size), dictItem.checksum);
+			size = dictItem->rawSize;
 			return true;
 		}
 	};
@@ -521,12 +2882,77 @@ public:
 	}
 
 	Unlime(std::string filename, Options options)
-	: datafileFilename(filename), options(options)
+	: datafileFilename(filename), options(options), resourceCache(options.cacheSize)
+	{
+	}
+
+	~Unlime()
+	{
+		stopScrub();
+		drain();
+		workerPool.reset();
+	}
+
+	// queues extraction of an item on the internal thread pool; decompression and the
+	// integrity check run on a worker thread while the calling thread continues
+	// exceptions thrown during extraction are rethrown by the handle's get()
+	T_AsyncHandle getAsync(std::string_view category, std::string_view key)
+	{
+		std::unique_lock<std::mutex> lock(asyncMutex);
+		acquireWorkerPool();
+		if (!asyncExtractor)
+		{
+			asyncExtractor = std::make_unique<Extractor>(*this);
+		}
+		++n_asyncPending;
+		lock.unlock();
+
+		auto task = std::make_shared<std::packaged_task<AsyncResult()>>([this, category = std::string(category), key = std::string(key)]() {
+			AsyncResult result;
+			result.found = asyncExtractor->get(result.data, category, key);
+			return result;
+		});
+		T_AsyncHandle handle = task->get_future();
+		workerPool->submit([this, task]() {
+			(*task)();
+			finishAsyncRequest();
+		});
+		return handle;
+	}
+
+	// polls whether an asynchronous request has completed
+	static bool isReady(T_AsyncHandle const& handle)
+	{
+		return handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// blocks until all pending asynchronous requests have completed
+	void drain()
+	{
+		std::unique_lock<std::mutex> lock(asyncMutex);
+		asyncIdleCondition.wait(lock, [this]() { return n_asyncPending == 0; });
+	}
+
+	CacheStats cacheStats()
+	{
+		return resourceCache.stats();
+	}
+
+	// state of the background integrity scrub, FAILED if corrupted data was found
+	// (only used with IntegrityPolicy::SCRUB, the scrub starts once the dictionary is read)
+	ScrubState scrubState() const
 	{
+		return scrubStatus.load();
 	}
 
+	// must not be called while other threads are extracting data
 	void dropDict()
 	{
+		stopScrub();
+		std::lock_guard<std::mutex> lock(dictMutex);
+		resourceCache.clear();
+		lastSolidGroup.reset();
+		residentBlocks.clear();
 		dictMap.clear();
 		wasValidated = false;
 		dictWasRead = false;
@@ -40,10 +40,16 @@
 #define UNLIME_PHONY
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <fstream>
 #include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <chrono>
 #include <zlib.h>
 
 class Unlime
@@ -76,11 +82,89 @@ public:
 
 	using T_Bytes = std::vector<Bytef>;
 
+	struct Query
+	{
+		std::string category;
+		std::string key;
+		T_Bytes* data = nullptr;
+		bool found = false;
+	};
+
+	struct AsyncResult
+	{
+		bool found = false;
+		T_Bytes data;
+	};
+
+	using T_AsyncHandle = std::future<AsyncResult>;
+
+	enum class Codec : unsigned char
+	{
+		DEFLATE, STORED, LZ, PRESET, SOLID
+	};
+
+	struct RawData
+	{
+		T_Bytes data;
+		Codec codec = Codec::DEFLATE;
+		uint64_t rawSize = 0;
+		uint32_t blockSize = 0;
+		uint32_t solidOffset = 0;
+		uint32_t checksum = 0;
+		T_Bytes const* preset = nullptr;
+	};
+
+	struct DataView
+	{
+		Bytef const* data = nullptr;
+		size_t size = 0;
+	};
+
+	class Extractor;
+
+	struct ResourceId
+	{
+		uint32_t category = 0;
+		uint32_t item = 0;
+		std::string_view categoryName;
+		std::string_view keyName;
+		uint64_t size = 0;
+		uint64_t dictId = 0;
+	};
+
+	struct CacheStats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		size_t size = 0;
+		size_t n_items = 0;
+	};
+
+	enum class IntegrityPolicy : unsigned char
+	{
+		ALWAYS, FIRST_ACCESS, SAMPLED, SCRUB
+	};
+
+	enum class ScrubState : unsigned char
+	{
+		IDLE, RUNNING, PASSED, FAILED
+	};
+
 	struct Options
 	{
 		bool integrityCheck = true;
+		IntegrityPolicy integrityPolicy = IntegrityPolicy::ALWAYS;
+		size_t integritySampleRate = 16;
 		bool checkHeadString = false;
 		std::string headString;
+		bool memoryMap = false;
+		size_t threadCount = 0;
+		size_t cacheSize = 0;
+		std::vector<std::string> residentCategories;
+		bool lazyDict = true;
+		size_t readBufferSize = 16u * 1024u;
+		size_t batchReadSize = 4u * 1024u * 1024u;
+		bool parallelInflate = true;
 	};
 
 private:
@@ -161,7 +245,8 @@ private:
 	using T_DictMap = std::unordered_map<std::string, T_DictCategory>;
 
 	T_DictMap dictMap;
-	bool dictWasRead = false;
+	std::atomic<bool> dictWasRead { false };
+	std::mutex dictMutex;
 
 	std::string resourceDirectory;
 
@@ -211,7 +296,12 @@ private:
 			auto [ptype, key, value] = INIParse::parseLine(line);
 			if (ptype == INIParse::PDataType::PDATA_SECTION)
 			{
-				inSection = true;
+				// sections starting with ! hold packing options (such as [!solid]), not resources
+				inSection = !(key.size() && key[0] == '!');
+				if (!inSection)
+				{
+					continue;
+				}
 				category = key;
 				sectionIsMeta = category[0] == '@';
 				if (sectionIsMeta)
@@ -254,7 +344,20 @@ private:
 		}
 
 		// done reading dict
-		dictWasRead = true;
+		dictWasRead.store(true, std::memory_order_release);
+	}
+
+	void prepareDict()
+	{
+		if (dictWasRead.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(dictMutex);
+		if (!dictWasRead.load(std::memory_order_relaxed))
+		{
+			readDict();
+		}
 	}
 
 	Unlime(Unlime const&) = delete;
@@ -263,6 +366,23 @@ private:
 	const Unlime& operator=(Unlime&& other) = delete;
 
 public:
+	class Handle
+	{
+	private:
+		friend class Extractor;
+
+		// phony handles keep the names and look the resource up again on every get()
+		bool found = false;
+		std::string category;
+		std::string key;
+
+	public:
+		explicit operator bool() const
+		{
+			return found;
+		}
+	};
+
 	class Extractor
 	{
 	private:
@@ -283,19 +403,16 @@ public:
 		{
 		}
 
-		bool get(T_Bytes& data, std::string const& category, std::string const& key) const
+		bool get(T_Bytes& data, std::string_view category, std::string_view key) const
 		{
-			if (!unlime->dictWasRead)
-			{
-				unlime->readDict();
-			}
-			auto it = unlime->dictMap.find(category);
+			unlime->prepareDict();
+			auto it = unlime->dictMap.find(std::string(category));
 			if (it == unlime->dictMap.end())
 			{
 				return false;
 			}
 			auto& collection = it->second;
-			auto it2 = collection.map.find(key);
+			auto it2 = collection.map.find(std::string(key));
 			if (it2 == collection.map.end())
 			{
 				return false;
@@ -342,6 +459,144 @@ public:
 			}
 			return true;
 		}
+
+		bool get(T_Bytes& data, ResourceId const& id) const
+		{
+			// phony extraction looks resources up by name
+			return get(data, id.categoryName, id.keyName);
+		}
+
+		Handle find(std::string_view category, std::string_view key) const
+		{
+			Handle handle;
+			uint64_t size = 0;
+			handle.found = sizeOf(size, category, key);
+			handle.category = category;
+			handle.key = key;
+			return handle;
+		}
+
+		bool get(T_Bytes& data, Handle const& handle) const
+		{
+			return handle && get(data, handle.category, handle.key);
+		}
+
+		bool view(DataView&, std::string_view, std::string_view) const
+		{
+			// files are never mapped, items are always extracted
+			return false;
+		}
+
+		bool view(DataView&, Handle const&) const
+		{
+			return false;
+		}
+
+		bool getRaw(RawData& raw, std::string_view category, std::string_view key) const
+		{
+			// there is no stored data, so it is compressed on the spot
+			T_Bytes data;
+			if (!get(data, category, key))
+			{
+				return false;
+			}
+			uLong compressedSize = compressBound(static_cast<uLong>(data.size()));
+			raw.data.resize(compressedSize);
+			if (compress2(raw.data.data(), &compressedSize, data.data(), static_cast<uLong>(data.size()), 9) != Z_OK)
+			{
+				throw Exception::Unknown();
+			}
+			raw.data.resize(compressedSize);
+			raw.codec = Codec::DEFLATE;
+			raw.rawSize = data.size();
+			raw.blockSize = 0;
+			raw.solidOffset = 0;
+			raw.checksum = adler32_z(0ul, data.data(), data.size());
+			raw.preset = nullptr;
+			return true;
+		}
+
+		bool getRaw(RawData& raw, Handle const& handle) const
+		{
+			return handle && getRaw(raw, handle.category, handle.key);
+		}
+
+		bool read(T_Bytes& data, Handle const& handle, uint64_t offset, size_t length) const
+		{
+			// phony extraction reads the whole file and keeps the requested range
+			T_Bytes itemData;
+			if (!get(itemData, handle))
+			{
+				return false;
+			}
+			if (offset >= itemData.size())
+			{
+				data.clear();
+				return true;
+			}
+			length = static_cast<size_t>(std::min(static_cast<uint64_t>(length), itemData.size() - offset));
+			data.assign(itemData.begin() + static_cast<size_t>(offset), itemData.begin() + static_cast<size_t>(offset + length));
+			return true;
+		}
+
+		size_t getMany(std::vector<Query>& queries) const
+		{
+			size_t n_found = 0;
+			for (auto& query : queries)
+			{
+				query.found = (query.data != nullptr && get(*query.data, query.category, query.key));
+				if (query.found)
+				{
+					++n_found;
+				}
+			}
+			return n_found;
+		}
+
+		bool pin(std::string_view category, std::string_view key) const
+		{
+			// phony extraction doesn't cache data
+			uint64_t size = 0;
+			return sizeOf(size, category, key);
+		}
+
+		bool unpin(std::string_view category, std::string_view key) const
+		{
+			uint64_t size = 0;
+			return sizeOf(size, category, key);
+		}
+
+		bool sizeOf(uint64_t& size, std::string_view category, std::string_view key) const
+		{
+			unlime->prepareDict();
+			auto it = unlime->dictMap.find(std::string(category));
+			if (it == unlime->dictMap.end())
+			{
+				return false;
+			}
+			auto& collection = it->second;
+			auto it2 = collection.map.find(std::string(key));
+			if (it2 == collection.map.end())
+			{
+				return false;
+			}
+			std::string& value = it2->second;
+			if (collection.isMeta)
+			{
+				size = value.size();
+			}
+			else
+			{
+				std::string const resourceFilename = unlime->resourceDirectory + value;
+				std::ifstream resourceStream(resourceFilename, std::ios::in | std::ifstream::binary | std::ifstream::ate);
+				if (!resourceStream.is_open())
+				{
+					throw Exception::UnableToOpen(resourceFilename);
+				}
+				size = static_cast<uint64_t>(resourceStream.tellg());
+			}
+			return true;
+		}
 	};
 
 	Unlime(std::string filename)
@@ -354,8 +609,45 @@ public:
 	{
 	}
 
+	T_AsyncHandle getAsync(std::string_view category, std::string_view key)
+	{
+		// phony extraction is done synchronously
+		std::promise<AsyncResult> promise;
+		try {
+			Extractor ex(*this);
+			AsyncResult result;
+			result.found = ex.get(result.data, category, key);
+			promise.set_value(std::move(result));
+		}
+		catch (...) {
+			promise.set_exception(std::current_exception());
+		}
+		return promise.get_future();
+	}
+
+	static bool isReady(T_AsyncHandle const& handle)
+	{
+		return handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	void drain()
+	{
+	}
+
+	CacheStats cacheStats()
+	{
+		return CacheStats();
+	}
+
+	ScrubState scrubState() const
+	{
+		// there is no datafile to scrub
+		return ScrubState::IDLE;
+	}
+
 	void dropDict()
 	{
+		std::lock_guard<std::mutex> lock(dictMutex);
 		dictMap.clear();
 		dictWasRead = false;
 		resourceDirectory = "";